@@ -0,0 +1,143 @@
+#ifndef _AI_H_
+#define _AI_H_
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "game.h"
+#include "worker_pool.h"
+
+/* Score of inserting colour at index, cascades included, field unchanged.
+ * removed is scratch. */
+int greedy_score(Game &game, Field &field, int index, int colour,
+    FieldUndo &undo, std::vector<FieldPattern> &removed)
+{
+  int score = 0;
+
+  removed.clear();
+  field.make_move(index, colour, undo, removed);
+  field.unmake_move(undo);
+
+  for (FieldPattern p : removed) score += game.get_pattern_score(p);
+
+  return score;
+}
+
+/* Best index of greedy_score() in one thread (ties: lowest index). */
+int greedy_index(Game &game, Field &field,
+    FieldUndo &undo, std::vector<FieldPattern> &removed)
+{
+  int colour = game.get_waiting_colour();
+  int best_index = 0, best_score = -1;
+
+  for (int index = 0; index < field.get_bounds_max(); index++)
+  {
+    int score = greedy_score(game, field, index, colour, undo, removed);
+
+    if (score > best_score)
+    {
+      best_score = score;
+      best_index = index;
+    }
+  }
+
+  return best_index;
+}
+
+/**
+ * Headless player, which takes the insertion index with the highest score
+ * of the current waiting colour, cascades included (ties: lowest index).
+ * The candidates are shared by a pool of worker threads, each with its own
+ * copy of the field, which is made and unmade per candidate.
+ * Candidates, which were not started before the deadline, are skipped.
+ */
+class GreedyPlayer
+{
+  private:
+    WorkerPool pool;
+    std::mutex mutex;  // for the best index.
+
+    int best_index, best_score, evaluated;
+
+  public:
+    /* Start the workers, 0: one per hardware thread. */
+    GreedyPlayer(int threads = 0);
+
+    int count_threads();
+
+    /* Evaluate the insertion indices of the game within time_budget (ms),
+     * return the best. The game is not changed. */
+    int choose_index(Game &game, long time_budget);
+
+    /* Score of the last chosen index. */
+    int get_best_score();
+
+    /* Number of candidates, the last choose_index() evaluated. */
+    int count_evaluated();
+};
+
+GreedyPlayer::GreedyPlayer(int threads) : pool(threads)
+{
+}
+
+int GreedyPlayer::count_threads()
+{
+  return this->pool.count_threads();
+}
+
+int GreedyPlayer::get_best_score()
+{
+  return this->best_score;
+}
+
+int GreedyPlayer::count_evaluated()
+{
+  return this->evaluated;
+}
+
+/**
+ * Per worker: copy the field once, then make and unmake the candidates.
+ * The first candidate is always evaluated, even after the deadline.
+ */
+int GreedyPlayer::choose_index(Game &game, long time_budget)
+{
+  std::chrono::steady_clock::time_point deadline
+    = std::chrono::steady_clock::now()
+    + std::chrono::milliseconds(time_budget);
+  std::atomic<int> next_index(0);
+
+  this->best_index = 0;
+  this->best_score = -1;
+  this->evaluated = 0;
+
+  pool.run([&] (int)
+  {
+    FieldUndo undo;
+    std::vector<FieldPattern> removed;
+
+    Field field = *game.get_field();
+    int colour = game.get_waiting_colour();
+    int bounds_max = field.get_bounds_max();
+
+    for (int index = next_index++; index < bounds_max; index = next_index++)
+    {
+      if (index > 0 && std::chrono::steady_clock::now() > deadline) break;
+
+      int score = greedy_score(game, field, index, colour, undo, removed);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      this->evaluated ++;
+      if (score > best_score || (score == best_score && index < best_index))
+      {
+        this->best_score = score;
+        this->best_index = index;
+      }
+    }
+  });
+
+  return this->best_index;
+}
+
+#endif // _AI_H_
@@ -0,0 +1,186 @@
+#ifndef _ATLAS_H_
+#define _ATLAS_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Place of a picture or a frame in the atlas, in pixels. */
+class AtlasRect
+{
+  public:
+    int x = 0, y = 0, w = 0, h = 0;
+};
+
+/* Picture, cut into equal frames. */
+class AtlasImage
+{
+  public:
+    std::string name;
+    AtlasRect rect;  // in the atlas, after pack().
+    int frame_w = 0, frame_h = 0;
+    int frames_x = 0, frames_y = 0;
+    int first_frame = 0;  // id of its first frame.
+};
+
+/**
+ * Layout of many pictures in one atlas: the pictures are placed on shelves
+ * (rows of the height of their highest picture), highest pictures first.
+ * Every picture is cut into frames, the frames get consecutive ids, row by
+ * row, which can be looked up by the picture's name once; drawing then only
+ * indexes the frame table.
+ */
+class AtlasLayout
+{
+  private:
+    std::vector<AtlasImage> images;  // in the order added.
+    std::vector<AtlasRect> frames;  // by id.
+    std::map<std::string, int> names;  // name to image.
+
+    int width = 0, height = 0;
+
+  public:
+    /* Add a picture (w x h), cut into frames (frame_w x frame_h, whole
+     * frames only; <= 0: the whole picture). Return its index. */
+    int add(std::string name, int w, int h, int frame_w = 0, int frame_h = 0);
+
+    /* Place the pictures, at most max_width wide, and cut the frames.
+     * Return false, if a picture is wider. */
+    bool pack(int max_width = 512);
+
+    int get_width();
+    int get_height();
+
+    long unsigned int count_images();
+    const AtlasImage &get_image(long unsigned int index);
+
+    /* Index of the picture with that name, -1: none. */
+    int find(std::string name);
+
+    long unsigned int count_frames();
+    const AtlasRect &get_frame(long unsigned int id);
+};
+
+int AtlasLayout::add(std::string name, int w, int h, int frame_w, int frame_h)
+{
+  AtlasImage image;
+
+  image.name = name;
+  image.rect.w = w;
+  image.rect.h = h;
+  image.frame_w = frame_w > 0 && frame_w <= w ? frame_w : w;
+  image.frame_h = frame_h > 0 && frame_h <= h ? frame_h : h;
+  image.frames_x = image.frame_w > 0 ? w / image.frame_w : 0;
+  image.frames_y = image.frame_h > 0 ? h / image.frame_h : 0;
+
+  this->names[name] = images.size();
+  this->images.push_back(image);
+
+  return images.size() - 1;
+}
+
+bool AtlasLayout::pack(int max_width)
+{
+  std::vector<int> order;
+  for (long unsigned int i = 0; i < images.size(); i++) order.push_back(i);
+
+  /* Highest first (stable insertion sort, few pictures). */
+  for (long unsigned int i = 1; i < order.size(); i++)
+  {
+    for (long unsigned int j = i; j > 0
+        && images[order[j]].rect.h > images[order[j - 1]].rect.h; j--)
+    {
+      std::swap(order[j], order[j - 1]);
+    }
+  }
+
+  int shelf_y = 0, shelf_h = 0, shelf_x = 0;
+
+  this->width = 0;
+  this->height = 0;
+
+  for (int i : order)
+  {
+    AtlasRect &rect = images[i].rect;
+
+    if (rect.w > max_width) return false;
+
+    if (shelf_x + rect.w > max_width)  // next shelf.
+    {
+      shelf_y += shelf_h;
+      shelf_x = 0;
+      shelf_h = 0;
+    }
+
+    rect.x = shelf_x;
+    rect.y = shelf_y;
+
+    shelf_x += rect.w;
+    if (rect.h > shelf_h) shelf_h = rect.h;
+
+    if (shelf_x > width) this->width = shelf_x;
+    if (shelf_y + shelf_h > height) this->height = shelf_y + shelf_h;
+  }
+
+  /* Cut the frames, in the order the pictures were added. */
+  this->frames.clear();
+
+  for (AtlasImage &image : images)
+  {
+    image.first_frame = frames.size();
+
+    for (int fy = 0; fy < image.frames_y; fy++)
+    {
+      for (int fx = 0; fx < image.frames_x; fx++)
+      {
+        AtlasRect frame;
+        frame.x = image.rect.x + fx * image.frame_w;
+        frame.y = image.rect.y + fy * image.frame_h;
+        frame.w = image.frame_w;
+        frame.h = image.frame_h;
+        this->frames.push_back(frame);
+      }
+    }
+  }
+
+  return true;
+}
+
+int AtlasLayout::get_width()
+{
+  return this->width;
+}
+
+int AtlasLayout::get_height()
+{
+  return this->height;
+}
+
+long unsigned int AtlasLayout::count_images()
+{
+  return this->images.size();
+}
+
+const AtlasImage &AtlasLayout::get_image(long unsigned int index)
+{
+  return this->images[index];
+}
+
+int AtlasLayout::find(std::string name)
+{
+  auto found = names.find(name);
+  return found == names.end() ? -1 : found->second;
+}
+
+long unsigned int AtlasLayout::count_frames()
+{
+  return this->frames.size();
+}
+
+const AtlasRect &AtlasLayout::get_frame(long unsigned int id)
+{
+  return this->frames[id];
+}
+
+#endif // _ATLAS_H_
@@ -0,0 +1,195 @@
+#ifndef _BIT_FIELD_H_
+#define _BIT_FIELD_H_
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "field.h"
+#include "field_backend.h"
+
+/* Field backend with one bitmask per colour and row.
+ * Bit col of plane (colour, row) is set, if that cell has that colour.
+ * It behaves like Field, but searches patterns with shift-and-AND. */
+class BitField : public FieldBackend<BitField>
+{
+  friend class FieldBackend<BitField>;
+
+  private:
+    int rows, cols, size;
+    int colours;  // number of planes, including the unused empty plane 0.
+    std::vector<uint64_t> planes;  // [colour * rows + row]
+
+    // search scratch, one entry per colour.
+    std::vector<uint64_t> covered_bits, row_live, row_h, row_v;
+
+    uint64_t plane(int colour, int row);
+
+    static const char *name() { return "BitField"; }
+
+    int cell(int row, int col);  // unchecked.
+    int put(int row, int col, int colour);  // unchecked, return old field
+
+  public:
+    static const int MAX_COLS = 64;
+
+    // number of rows and cols, at most MAX_COLS columns.
+    BitField(int rows = 5, int cols = 5);
+
+    void resize(int rows, int cols);  // reset the whole field dimensions.
+
+    int get_size();
+    int get_rows();
+    int get_cols();
+
+    // same patterns in the same order as Field::search_patterns().
+    using FieldBackend<BitField>::search_patterns;
+    int search_patterns(std::vector<FieldPattern> &found);
+};
+
+BitField::BitField(int rows, int cols)
+{
+  this->resize(rows, cols);
+}
+
+void BitField::resize(int rows, int cols)
+{
+  if (cols > MAX_COLS)
+  {
+    std::cerr << "BitField::resize("<<(rows)<<", "<<(cols)<<") "
+      << "- Too many columns, use " << MAX_COLS << "." << std::endl;
+    cols = MAX_COLS;
+  }
+
+  this->rows = rows;
+  this->cols = cols;
+  this->size = rows * cols;
+
+  this->colours = 1;  // only empty.
+  this->planes.assign(rows, 0);
+}
+
+int BitField::get_size()
+{
+  return this->size;
+}
+
+int BitField::get_rows()
+{
+  return this->rows;
+}
+
+int BitField::get_cols()
+{
+  return this->cols;
+}
+
+uint64_t BitField::plane(int colour, int row)
+{
+  if (colour < 1 || colour >= colours || row < 0 || row >= rows)
+    return 0;
+  return this->planes[colour * rows + row];
+}
+
+int BitField::cell(int row, int col)
+{
+  uint64_t bit = (uint64_t) 1 << col;
+
+  for (int colour = 1; colour < colours; colour++)
+  {
+    if (this->planes[colour * rows + row] & bit) return colour;
+  }
+  return 0;
+}
+
+int BitField::put(int row, int col, int colour)
+{
+  if (colour >= colours)  // new colour, add planes.
+  {
+    this->colours = colour + 1;
+    this->planes.resize(colours * rows, 0);
+  }
+
+  uint64_t bit = (uint64_t) 1 << col;
+  int old = this->cell(row, col);
+
+  if (old > 0) this->planes[old * rows + row] &= ~bit;
+  if (colour > 0) this->planes[colour * rows + row] |= bit;
+
+  return old;
+}
+
+/**
+ * Bottom row up: Per colour, cells already taken by vertical patterns from
+ * below are masked out, the remaining triples give the horizontal patterns.
+ * Pattern inner cells can not start a vertical pattern (like in Field).
+ */
+int BitField::search_patterns(std::vector<FieldPattern> &found)
+{
+  found.clear();
+
+  this->covered_bits.assign(colours, 0);
+  this->row_live.assign(colours, 0);
+  this->row_h.assign(colours, 0);
+  this->row_v.assign(colours, 0);
+
+  for (int row = 0; row < rows; row++)
+  {
+    uint64_t any = 0;
+
+    for (int colour = 1; colour < colours; colour++)
+    {
+      uint64_t here = plane(colour, row);
+      uint64_t above = plane(colour, row + 1);
+      uint64_t live = here & ~covered_bits[colour];
+
+      uint64_t triples = live & (live >> 1) & (live >> 2);
+      uint64_t h_start = triples & ~(live << 1);
+      uint64_t h_inner = ((triples << 1) | (triples << 2)) & ~h_start;
+
+      uint64_t v_start = live & ~h_inner & above & plane(colour, row + 2);
+
+      row_live[colour] = live;
+      row_h[colour] = h_start;
+      row_v[colour] = v_start;
+      any |= h_start | v_start;
+
+      // vertical patterns go on, while the colour is continued above.
+      covered_bits[colour] = (covered_bits[colour] | v_start) & above;
+    }
+
+    // emit in the field's order: by position, horizontal first.
+    while (any)
+    {
+      int col = __builtin_ctzll(any);
+      uint64_t bit = (uint64_t) 1 << col;
+      any &= any - 1;
+
+      for (int colour = 1; colour < colours; colour++)
+      {
+        if (row_h[colour] & bit)
+        {
+          // maximal run within the not yet covered cells.
+          uint64_t rest = ~(row_live[colour] >> col);
+          int type = rest ? __builtin_ctzll(rest) : MAX_COLS;
+
+          found.push_back(FieldPattern(row*cols + col, type, colour));
+        }
+
+        if (row_v[colour] & bit)
+        {
+          int type = -3;
+          while (plane(colour, row - type) & bit) type -= 1;
+
+          found.push_back(FieldPattern(row*cols + col, type, colour));
+        }
+
+        if ((row_h[colour] | row_v[colour]) & bit) break;
+      }
+    }
+  }
+
+  return found.size();
+}
+
+#endif // _BIT_FIELD_H_
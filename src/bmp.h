@@ -0,0 +1,139 @@
+#ifndef _BMP_H_
+#define _BMP_H_
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Uncompressed BMP pictures (24 or 32 bits per pixel, also with the
+ * usual colour masks), without SDL. Pixels are 0xRRGGBB, row by row from
+ * the top.
+ */
+
+static uint32_t bmp_get(const std::vector<unsigned char> &data, int at, int bytes)
+{
+  uint32_t value = 0;
+  for (int i = 0; i < bytes; i++) value |= (uint32_t) data[at + i] << (8 * i);
+  return value;
+}
+
+static void bmp_put(std::vector<unsigned char> &data, uint32_t value, int bytes)
+{
+  for (int i = 0; i < bytes; i++) data.push_back((unsigned char) (value >> (8 * i)));
+}
+
+/* Shift of the lowest set bit. */
+static int bmp_shift(uint32_t mask)
+{
+  int shift = 0;
+  while (mask && !(mask & 1)) mask >>= 1, shift++;
+  return shift;
+}
+
+/* Read the picture; false, if it can not be read or is not supported. */
+bool read_bmp(std::string path, std::vector<uint32_t> &pixels,
+    int &width, int &height)
+{
+  std::ifstream file(path, std::ios::binary);
+  std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)),
+      std::istreambuf_iterator<char>());
+
+  if (data.size() < 54 || data[0] != 'B' || data[1] != 'M')
+  {
+    std::cerr << "read_bmp(" << path << ") - no BMP." << std::endl;
+    return false;
+  }
+
+  long unsigned int offset = bmp_get(data, 10, 4);
+  int header = bmp_get(data, 14, 4);
+  int w = (int32_t) bmp_get(data, 18, 4), h = (int32_t) bmp_get(data, 22, 4);
+  int bits = bmp_get(data, 28, 2), compression = bmp_get(data, 30, 4);
+  uint32_t masks[3] = { 0xff0000, 0x00ff00, 0x0000ff };
+
+  if (compression == 3 && header >= 52)  // masks in the header.
+  {
+    for (int i = 0; i < 3; i++) masks[i] = bmp_get(data, 54 + 4 * i, 4);
+  }
+
+  bool top_down = h < 0;
+  if (top_down) h = -h;
+
+  long unsigned int row = (w * bits / 8 + 3) / 4 * 4;
+
+  if ((bits != 24 && bits != 32) || (compression != 0 && compression != 3)
+      || w <= 0 || offset + row * h > data.size())
+  {
+    std::cerr << "read_bmp(" << path << ") - not supported." << std::endl;
+    return false;
+  }
+
+  width = w;
+  height = h;
+  pixels.resize(w * h);
+
+  for (int y = 0; y < h; y++)
+  {
+    long unsigned int at = offset + row * (top_down ? y : h - 1 - y);
+
+    for (int x = 0; x < w; x++, at += bits / 8)
+    {
+      uint32_t pixel = bmp_get(data, at, bits / 8), colour = 0;
+
+      for (int c = 0; c < 3; c++)
+      {
+        colour = colour << 8 | ((pixel & masks[c]) >> bmp_shift(masks[c]) & 0xff);
+      }
+
+      pixels[y * w + x] = colour;
+    }
+  }
+
+  return true;
+}
+
+/* Write the picture (24 bits per pixel); false, if it can not be written. */
+bool write_bmp(std::string path, const uint32_t *pixels, int width, int height)
+{
+  long unsigned int row = (width * 3 + 3) / 4 * 4;
+  std::vector<unsigned char> data;
+
+  data.push_back('B');
+  data.push_back('M');
+  bmp_put(data, 54 + row * height, 4);  // file size.
+  bmp_put(data, 0, 4);
+  bmp_put(data, 54, 4);  // pixels' offset.
+
+  bmp_put(data, 40, 4);  // info header.
+  bmp_put(data, width, 4);
+  bmp_put(data, height, 4);  // bottom up.
+  bmp_put(data, 1, 2);  // planes.
+  bmp_put(data, 24, 2);
+  bmp_put(data, 0, 4);  // uncompressed.
+  bmp_put(data, row * height, 4);
+  bmp_put(data, 2835, 4);  // 72 dpi.
+  bmp_put(data, 2835, 4);
+  bmp_put(data, 0, 4);
+  bmp_put(data, 0, 4);
+
+  for (int y = height - 1; y >= 0; y--)
+  {
+    for (int x = 0; x < width; x++) bmp_put(data, pixels[y * width + x], 3);
+    for (long unsigned int p = width * 3; p < row; p++) data.push_back(0);
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  file.write((const char *) data.data(), data.size());
+
+  if (!file)
+  {
+    std::cerr << "write_bmp(" << path << ") - not written." << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+#endif // _BMP_H_
@@ -0,0 +1,159 @@
+#ifndef _COLUMN_FIELD_H_
+#define _COLUMN_FIELD_H_
+
+#include <iostream>
+#include <vector>
+
+#include "field.h"
+#include "field_backend.h"
+
+/* Field backend, stored column by column (bottom up) with a fill height
+ * per column. It behaves like Field, but gravity compacts each column in
+ * one pass and only where a gap was made, and inserting on top of a column,
+ * which is not full, is a single push. */
+class ColumnField : public FieldBackend<ColumnField>
+{
+  friend class FieldBackend<ColumnField>;
+
+  private:
+    int rows, cols, size;
+    std::vector<int> cells;  // [col * rows + row]
+
+    std::vector<int> height;  // per column: one above the highest colour.
+    std::vector<bool> gaps;  // per column: empty cells below the height.
+
+    std::vector<int> covered;  // search scratch.
+
+    static const char *name() { return "ColumnField"; }
+
+    int *search_scratch();
+
+    int cell(int row, int col);  // unchecked.
+    int put(int row, int col, int colour);  // unchecked, return old field
+
+    void push_top(int col, int colour);
+
+  public:
+    // number of rows and cols
+    ColumnField(int rows = 5, int cols = 5);
+
+    void resize(int rows, int cols);  // reset the whole field dimensions.
+
+    int get_size();
+    int get_rows();
+    int get_cols();
+
+    int get_height(int col);  // filled cells of that column, if no gaps.
+
+    void fix_gavity(); // fill all gaps, if something is above.
+};
+
+ColumnField::ColumnField(int rows, int cols)
+{
+  this->resize(rows, cols);
+}
+
+void ColumnField::resize(int rows, int cols)
+{
+  this->rows = rows;
+  this->cols = cols;
+  this->size = rows * cols;
+
+  this->cells.assign(size, 0);
+  this->height.assign(cols, 0);
+  this->gaps.assign(cols, false);
+  this->covered.assign(cols, -1);
+}
+
+int ColumnField::get_size()
+{
+  return this->size;
+}
+
+int ColumnField::get_rows()
+{
+  return this->rows;
+}
+
+int ColumnField::get_cols()
+{
+  return this->cols;
+}
+
+int ColumnField::get_height(int col)
+{
+  return col < 0 || col >= cols ? -1 : this->height[col];
+}
+
+int *ColumnField::search_scratch()
+{
+  return this->covered.data();
+}
+
+int ColumnField::cell(int row, int col)
+{
+  return this->cells[col * rows + row];
+}
+
+int ColumnField::put(int row, int col, int colour)
+{
+  int *column = &cells[col * rows];
+  int old = column[row];
+
+  column[row] = colour;
+
+  if (colour > 0 && row >= height[col])  // new top, maybe floating.
+  {
+    gaps[col] = gaps[col] || row > height[col];
+    height[col] = row + 1;
+  }
+  else if (!colour && old > 0 && row == height[col] - 1)  // top removed.
+  {
+    while (height[col] > 0 && !column[height[col] - 1]) height[col]--;
+  }
+  else if (!colour && old > 0)  // hole below the top.
+  {
+    gaps[col] = true;
+  }
+
+  return old;
+}
+
+/* Falls on top of the stack, if the column is not full. */
+void ColumnField::push_top(int col, int colour)
+{
+  if (height[col] < rows)
+  {
+    this->set(height[col], col, colour);
+  }
+  else  // push the column down, until a gap, the bottom may fall out.
+  {
+    FieldBackend<ColumnField>::push_top(col, colour);
+  }
+}
+
+/* Compact only columns with gaps, each in one pass. */
+void ColumnField::fix_gavity()
+{
+  for (int col = 0; col < cols; col++)
+  {
+    if (!gaps[col]) continue;
+
+    int *column = &cells[col * rows];
+    int bottom = 0;
+
+    for (int row = 0; row < height[col]; row++)
+    {
+      if (column[row]) column[bottom++] = column[row];
+    }
+    for (int row = bottom; row < height[col]; row++)
+    {
+      column[row] = 0;
+    }
+
+    height[col] = bottom;
+    gaps[col] = false;
+  }
+}
+
+#endif // _COLUMN_FIELD_H_
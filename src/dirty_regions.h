@@ -0,0 +1,163 @@
+#ifndef _DIRTY_REGIONS_H_
+#define _DIRTY_REGIONS_H_
+
+#include <vector>
+
+/* Rectangle on the screen, in pixels. */
+class DirtyRect
+{
+  public:
+    int x = 0, y = 0, w = 0, h = 0;
+
+    DirtyRect(int x = 0, int y = 0, int w = 0, int h = 0)
+      : x(x), y(y), w(w), h(h)
+    {
+    }
+
+    bool empty() const { return w <= 0 || h <= 0; }
+    long area() const { return empty() ? 0 : (long) w * h; }
+
+    bool operator==(const DirtyRect &o) const
+    {
+      return x == o.x && y == o.y && w == o.w && h == o.h;
+    }
+
+    /* Overlapping or touching. */
+    bool meets(const DirtyRect &o) const
+    {
+      return x <= o.x + o.w && o.x <= x + w && y <= o.y + o.h && o.y <= y + h;
+    }
+
+    /* Grow to the bounding box of both. */
+    void unite(const DirtyRect &o)
+    {
+      int right = x + w > o.x + o.w ? x + w : o.x + o.w;
+      int bottom = y + h > o.y + o.h ? y + h : o.y + o.h;
+
+      this->x = x < o.x ? x : o.x;
+      this->y = y < o.y ? y : o.y;
+      this->w = right - x;
+      this->h = bottom - y;
+    }
+};
+
+/**
+ * Collects the parts of the screen, which changed since the last frame.
+ * Every drawn item is tracked by an id (stable from frame to frame), its
+ * area and a state value, which changes, if the item would look different;
+ * the old and the new area of a changed item are dirty.
+ * Touching dirty areas are merged; if they cover most of the screen, the
+ * whole screen is one area.
+ */
+class DirtyRegions
+{
+  private:
+    class Item
+    {
+      public:
+        DirtyRect rect;
+        long state = 0;
+        bool known = false;  // tracked before.
+    };
+
+    DirtyRect screen;
+    std::vector<Item> items;  // by id.
+    std::vector<DirtyRect> rects;
+
+  public:
+    DirtyRegions(int width, int height);
+
+    /* Compare the item with its last frame, mark its areas, if changed. */
+    void track(long unsigned int id, DirtyRect rect, long state);
+
+    /* Mark an area (clipped to the screen). */
+    void mark(DirtyRect rect);
+
+    /* Mark the whole screen, e.g. after it was covered. */
+    void mark_all();
+
+    bool empty();
+
+    /* Merged dirty areas since the last clear(). */
+    const std::vector<DirtyRect> &get_rects();
+
+    /* The dirty areas are drawn. */
+    void clear();
+};
+
+DirtyRegions::DirtyRegions(int width, int height) : screen(0, 0, width, height)
+{
+  this->mark_all();
+}
+
+void DirtyRegions::track(long unsigned int id, DirtyRect rect, long state)
+{
+  if (id >= items.size()) items.resize(id + 1);
+
+  Item &item = items[id];
+
+  if (item.known && item.state == state && item.rect == rect) return;
+
+  if (item.known) this->mark(item.rect);  // uncover the old look.
+  this->mark(rect);
+
+  item.rect = rect;
+  item.state = state;
+  item.known = true;
+}
+
+void DirtyRegions::mark(DirtyRect rect)
+{
+  /* Clip to the screen. */
+  if (rect.x < 0) rect.w += rect.x, rect.x = 0;
+  if (rect.y < 0) rect.h += rect.y, rect.y = 0;
+  if (rect.x + rect.w > screen.w) rect.w = screen.w - rect.x;
+  if (rect.y + rect.h > screen.h) rect.h = screen.h - rect.y;
+
+  if (rect.empty()) return;
+
+  /* Merge into a touching one, until none touches anymore. */
+  for (long unsigned int i = 0; i < rects.size(); )
+  {
+    if (rects[i].meets(rect))
+    {
+      rect.unite(rects[i]);
+      rects[i] = rects.back();
+      rects.pop_back();
+      i = 0;
+    }
+    else
+    {
+      i ++;
+    }
+  }
+
+  this->rects.push_back(rect);
+
+  long area = 0;
+  for (DirtyRect &r : rects) area += r.area();
+
+  if (area * 2 > screen.area()) this->mark_all();
+}
+
+void DirtyRegions::mark_all()
+{
+  this->rects.assign(1, screen);
+}
+
+bool DirtyRegions::empty()
+{
+  return this->rects.empty();
+}
+
+const std::vector<DirtyRect> &DirtyRegions::get_rects()
+{
+  return this->rects;
+}
+
+void DirtyRegions::clear()
+{
+  this->rects.clear();
+}
+
+#endif // _DIRTY_REGIONS_H_
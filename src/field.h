@@ -1,12 +1,48 @@
 #ifndef _FIELD_H_
 #define _FIELD_H_
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include "field_kernel.h"
+#include "random.h"
+
 // reference: https://www.youtube.com/watch?v=CXQXQgVflCI
 
+/* Cell indices of a pattern, computed while iterating, nothing allocated. */
+class PatternCells
+{
+  private:
+    int first, step, count;
+
+  public:
+    class iterator
+    {
+      private:
+        int index, step;
+
+      public:
+        iterator(int index, int step) : index(index), step(step) {}
+
+        int operator*() const { return index; }
+        iterator &operator++() { index += step; return *this; }
+        bool operator!=(const iterator &other) const { return index != other.index; }
+    };
+
+    PatternCells(int first = 0, int step = 1, int count = 0)
+      : first(first), step(step), count(count)
+    {}
+
+    iterator begin() const { return iterator(first, step); }
+    iterator end() const { return iterator(first + count*step, step); }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    int operator[](int i) const { return first + i*step; }
+};
+
 // triple of ints.
 class FieldPattern
 {
@@ -15,7 +51,7 @@ class FieldPattern
     int type; // negative: vertical, positive: horizontal
     int colour;
 
-    FieldPattern(int position, int type, int colour)
+    FieldPattern(int position = 0, int type = 0, int colour = 0)
       : position(position), type(type), colour(colour)
     {}
 
@@ -29,6 +65,12 @@ class FieldPattern
       return type < 0 ? -type : type;
     }
 
+    // its cell indices on a field with that many columns.
+    PatternCells cells(int cols)
+    {
+      return PatternCells(position, is_horizontal() ? 1 : cols, size());
+    }
+
     std::string to_string()
     {
       std::string str = "";
@@ -44,17 +86,86 @@ class FieldPattern
     }
 };
 
+/**
+ * Zobrist key of a colour on a cell (index), an empty cell has none.
+ * Keys are mixed from index and colour (splitmix64), so they need no table
+ * and are the same for every field of the same width.
+ */
+uint64_t zobrist_key(int index, int colour)
+{
+  if (colour <= 0) return 0;
+
+  uint64_t z = ((uint64_t) (uint32_t) index << 32 | (uint32_t) colour)
+    + 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/* A changed cell and its colour before the change. */
+class FieldChange
+{
+  public:
+    int index;
+    int colour;
+
+    FieldChange(int index, int colour) : index(index), colour(colour) {}
+};
+
+/* Undo log of made moves, a stack of changed cells. Reusable. */
+class FieldUndo
+{
+  public:
+    std::vector<FieldChange> changes;  // all moves, in change order.
+    std::vector<int> moves;  // per move: its first change in changes.
+
+    void clear()
+    {
+      changes.clear();
+      moves.clear();
+    }
+
+    int count_moves()
+    {
+      return moves.size();
+    }
+};
+
 class Field
 {
   private:
     int rows, size;
     std::vector<int> field;
 
+    uint64_t hash;  // xor of the zobrist keys of all cells.
+
+    // search scratch: per column, top row of a vertical pattern (-1: none)
+    // and top row of a vertical run, which may start a row later (-1: none).
+    std::vector<int> covered, pending;
+
+    /* Runs of at least three same colours, kept up to date line by line.
+     * hrun[i]: length of the horizontal run starting at i, else 0.
+     * vrun[i]: length of the vertical run starting (bottom) at i, else 0.
+     * row_runs[row]: number of runs starting in that row. */
+    std::vector<int> hrun, vrun, row_runs;
+
+    // changed spans since the last search: [lo, hi] per row and per column.
+    std::vector<int> row_lo, row_hi, col_lo, col_hi;
+    std::vector<int> dirty_rows, dirty_cols;
+
     int score[2];
 
+    FieldUndo *recording = NULL;  // log of the move in progress, if any.
+    std::vector<FieldPattern> move_patterns;  // search scratch of make_move.
+
     int set(int row, int col, int colour);  // return old field
     int set(int index, int colour);  // return old field
 
+    void mark_dirty(int row, int col);
+    void update_runs();  // rescan changed spans of dirty rows and columns.
+    void update_runs(int line, int lo, int hi, bool horizontal);
+    void rebuild_runs();  // find all runs again, with the run kernel.
+
   public:
     // number of rows and cols
     Field(int rows = 5, int cols = 5);
@@ -69,7 +180,10 @@ class Field
 
     int get_bounds_max();  // maximum positions for colour insertion.
 
+    uint64_t get_hash();  // zobrist hash of the current cells.
+
     void start(int field_variety = 7);  // number of different colours
+    void start(int field_variety, Random &random);  // drawn from random.
     void start(std::vector<int> starting_fields);
 
     int colour_at(int index);
@@ -80,8 +194,22 @@ class Field
 
     // check for every field, if they are in wining.
     std::vector<FieldPattern> *search_patterns();
+
+    // same, but fill the given (reused) list; return the number of patterns.
+    int search_patterns(std::vector<FieldPattern> &found);
+
     void remove_pattern(FieldPattern pattern, bool auto_gravity = true);
     void remove_patterns(std::vector<FieldPattern> *pattern, bool auto_gravity = true);
+    void remove_patterns(const std::vector<FieldPattern> &pattern, bool auto_gravity = true);
+
+    /* Insert and resolve the whole cascade, log every change into undo.
+     * Append the removed patterns to removed, in removal order.
+     * Return the number of cascade steps. */
+    int make_move(int index, int colour, FieldUndo &undo,
+        std::vector<FieldPattern> &removed);
+
+    /* Restore the field before the last move of undo, and drop that move. */
+    void unmake_move(FieldUndo &undo);
 };
 
 /** Create field size.*/
@@ -98,23 +226,51 @@ Field::~Field()
 
 void Field::resize(int rows, int cols)
 {
-  srand(time(0));
   this->size = rows * cols;
   this->rows = rows;
 
   this->field.clear();
   for (int i = 0; i < size; i++) this->field.push_back(0);  // fill all empty
+
+  this->hash = 0;  // all empty.
+
+  this->covered.assign(cols, -1);
+  this->pending.assign(cols, -1);
+
+  // empty field: no runs, nothing changed.
+  this->hrun.assign(size, 0);
+  this->vrun.assign(size, 0);
+  this->row_runs.assign(rows, 0);
+
+  this->row_lo.assign(rows, cols);
+  this->row_hi.assign(rows, -1);
+  this->col_lo.assign(cols, rows);
+  this->col_hi.assign(cols, -1);
+
+  this->dirty_rows.clear();
+  this->dirty_cols.clear();
+  this->dirty_rows.reserve(rows);
+  this->dirty_cols.reserve(cols);
 }
 
 /**
- * Start with random setup.
+ * Start with random setup, not to be replayed.
  */
 void Field::start(int field_variety)
+{
+  Random random(random_seed());
+  this->start(field_variety, random);
+}
+
+/**
+ * Start with random setup, drawn from the given engine.
+ */
+void Field::start(int field_variety, Random &random)
 {
   /* Randomly filled.*/
   for (int i = 0; i < this->size; i++)
   {
-    this->set(i, 1 + rand() % field_variety);
+    this->set(i, 1 + random.below(field_variety));
   }
 }
 
@@ -151,6 +307,11 @@ int Field::get_bounds_max()
   return this->get_rows() * 2 + this->get_cols();
 }
 
+uint64_t Field::get_hash()
+{
+  return this->hash;
+}
+
 /** Return colour on that position (index).
  * 0 if that field is empty.
  */
@@ -179,6 +340,13 @@ int Field::set(int index, int colour)
   {
     int old = this->colour_at(index);
     this->field[index] = colour;
+
+    if (old != colour)
+    {
+      this->hash ^= zobrist_key(index, old) ^ zobrist_key(index, colour);
+      if (recording) recording->changes.push_back(FieldChange(index, old));
+      this->mark_dirty(index / get_cols(), index % get_cols());
+    }
     return old;
   }
   else
@@ -288,96 +456,269 @@ void Field::insert(int index, int colour)
   this->fix_gavity();
 }
 
+/* Let every column fall down in one pass. */
 void Field::fix_gavity()
 {
-  int above = 0, colour_above = 0;
+  int cols = this->get_cols();
 
-  // for all cols
-  for (int col = 0; col < this->get_cols(); col++)
+  for (int col = 0; col < cols; col++)
   {
-    // for all fields in that col
-    for (int row = 0; row < rows-1; row++)  // bottom -> almost top
-    {
-      if (colour_at(row, col)) continue;  // skip if not empyt.
+    int bottom = col;  // next free cell from below.
 
-      // if  this is empty, get next not empty
-      above = row;
-      colour_above = 0;
+    for (int i = col, colour; i < size; i += cols)
+    {
+      if (!(colour = field[i])) continue;
 
-      while(!(colour_above = colour_at(above, col)) && above < rows)
+      if (bottom != i)
       {
-        above ++;
+        this->set(bottom, colour);
+        this->set(i, 0);
       }
-      this->set(row, col, colour_above > 0 ? colour_above : 0);
-      this->set(above, col, 0);  // empty next.
+      bottom += cols;
     }
   }
 }
 
+/** Remember the changed cell for its row and its column. */
+void Field::mark_dirty(int row, int col)
+{
+  if (row_hi[row] < 0) dirty_rows.push_back(row);
+  if (col_hi[col] < 0) dirty_cols.push_back(col);
+
+  if (col < row_lo[row]) row_lo[row] = col;
+  if (col > row_hi[row]) row_hi[row] = col;
+  if (row < col_lo[col]) col_lo[col] = row;
+  if (row > col_hi[col]) col_hi[col] = row;
+}
+
+void Field::update_runs()
+{
+  int changed = 0;
+
+  for (int row : dirty_rows) changed += row_hi[row] - row_lo[row] + 1;
+  for (int col : dirty_cols) changed += col_hi[col] - col_lo[col] + 1;
+
+  if (changed > size)  // most of the field changed, e.g. on start().
+  {
+    this->rebuild_runs();
+    return;
+  }
+
+  for (int row : dirty_rows)
+  {
+    this->update_runs(row, row_lo[row], row_hi[row], true);
+    row_lo[row] = get_cols();
+    row_hi[row] = -1;
+  }
+
+  for (int col : dirty_cols)
+  {
+    this->update_runs(col, col_lo[col], col_hi[col], false);
+    col_lo[col] = rows;
+    col_hi[col] = -1;
+  }
+
+  dirty_rows.clear();
+  dirty_cols.clear();
+}
+
+/**
+ * Rescan the changed span [lo, hi] of a row (or column), widened to the
+ * unchanged runs touching it: old and new runs end on the same borders there.
+ */
+void Field::update_runs(int line, int lo, int hi, bool horizontal)
+{
+  int cols = this->get_cols();
+  int length = horizontal ? cols : rows;
+  int first = horizontal ? line * cols : line;  // index of cell 0.
+  int step = horizontal ? 1 : cols;
+  std::vector<int> &runs = horizontal ? hrun : vrun;
+
+  int a = lo, b = hi, colour;
+
+  if (a > 0 && (colour = field[first + (a-1)*step]) > 0)
+  {
+    for (a--; a > 0 && field[first + (a-1)*step] == colour; a--);
+  }
+
+  if (b < length - 1 && (colour = field[first + (b+1)*step]) > 0)
+  {
+    for (b++; b < length - 1 && field[first + (b+1)*step] == colour; b++);
+  }
+
+  for (int j = a, i = first + a*step; j <= b; j++, i += step)
+  {
+    if (runs[i]) row_runs[i / cols] --;
+    runs[i] = 0;
+  }
+
+  for (int j = a, run; j <= b; j += run)
+  {
+    colour = field[first + j*step];
+
+    for (run = 1; j + run <= b && field[first + (j+run)*step] == colour; run++);
+
+    if (colour > 0 && run >= 3)
+    {
+      runs[first + j*step] = run;
+      row_runs[(first + j*step) / cols] ++;
+    }
+  }
+}
+
+/**
+ * Let the kernel skip all cells, which can not start a run of three.
+ * Only matches, which are the first of their run, are followed.
+ */
+void Field::rebuild_runs()
+{
+  int cols = this->get_cols();
+  int colour, run;
+  const int *cells = this->field.data();
+
+  this->hrun.assign(size, 0);
+  this->vrun.assign(size, 0);
+  this->row_runs.assign(rows, 0);
+
+  for (int row = 0; row < rows; row++)
+  {
+    const int *line = cells + row * cols;
+
+    for (int col = find_triple(line, line + 1, line + 2, cols - 2);
+        col < cols - 2;
+        col = find_triple(line, line + 1, line + 2, cols - 2, col + 1))
+    {
+      colour = line[col];
+      if (col > 0 && line[col - 1] == colour) continue;  // not the first.
+
+      for (run = 3; col + run < cols && line[col + run] == colour; run++);
+
+      hrun[row * cols + col] = run;
+      row_runs[row] ++;
+    }
+  }
+
+  for (int row = 0; row + 2 < rows; row++)
+  {
+    const int *line = cells + row * cols;
+
+    for (int col = find_triple(line, line + cols, line + 2*cols, cols);
+        col < cols;
+        col = find_triple(line, line + cols, line + 2*cols, cols, col + 1))
+    {
+      colour = line[col];
+      if (row > 0 && line[col - cols] == colour) continue;  // not the first.
+
+      for (run = 3; row + run < rows && line[col + run*cols] == colour; run++);
+
+      vrun[row * cols + col] = run;
+      row_runs[row] ++;
+    }
+  }
+
+  for (int row : dirty_rows)
+  {
+    row_lo[row] = cols;
+    row_hi[row] = -1;
+  }
+  for (int col : dirty_cols)
+  {
+    col_lo[col] = rows;
+    col_hi[col] = -1;
+  }
+
+  dirty_rows.clear();
+  dirty_cols.clear();
+}
+
 std::vector<FieldPattern> *Field::search_patterns()
 {
   std::vector<FieldPattern> *winning_regions = new std::vector<FieldPattern>();
-  std::vector<int> backup(this->field);  // if pattern later removed
+  this->search_patterns(*winning_regions);
+  return winning_regions;
+}
+
+/**
+ * Scan bottom row up, left to right, without touching the field.
+ * A cell belongs to at most one pattern, the first found (like removed):
+ * Cells of a vertical pattern are skipped in the rows above,
+ * inner cells of a horizontal pattern can not start a vertical one.
+ *
+ * Patterns only grow from runs of three, so only rows with a run (or a
+ * vertical run, pushed up by a horizontal pattern) are scanned. The runs
+ * are only rescanned where the field changed since the last search.
+ */
+int Field::search_patterns(std::vector<FieldPattern> &found)
+{
+  found.clear();
+
+  this->update_runs();
 
   int cols = this->get_cols();
-  int col, row, colour;
+  int length, inner_until, run_start, run_end, top, waiting = 0;
+
+  this->covered.assign(cols, -1);
+  this->pending.assign(cols, -1);
 
-  for (int i = 0; i < size; i++)
+  for (int row = 0, i = 0; row < rows; row++)
   {
-    colour = colour_at(i);
+    if (!row_runs[row] && !waiting)
+    {
+      i += cols;
+      continue;  // nothing can start in this row.
+    }
 
-    col = i % cols;
-    row = i / cols;
+    inner_until = 0;  // first column after the current horizontal pattern.
+    run_start = run_end = 0;  // current horizontal run.
 
-    // horizontal: after (+1)
-    if (col != cols-2 && colour && colour > 0
-        && colour_at(row, col+1) == colour && colour && colour_at(row, col+2) == colour
-        && colour_at(row, col-1) != colour)  // avoid overlapping
+    for (int col = 0; col < cols; col++, i++)
     {
-      int type = +3;
+      if (hrun[i])
+      {
+        run_start = col;
+        run_end = col + hrun[i];
+      }
+
+      if (covered[col] >= row) continue;  // taken.
 
-      // act, like it's deleted later
-      this->set(row,col + 0, 0);
-      this->set(row,col + 1, 0);
-      this->set(row,col + 2, 0);
+      bool inner = col < inner_until;
 
-      // increase pattern, if still on same row.
-      while (colour_at(row, col+type) == colour)
+      // horizontal: from the first free cell of a run, to the next taken.
+      if (!inner && col < run_end && (col == run_start || covered[col-1] >= row))
       {
-        this->set(row,col + type, 0);
-        type += 1;
+        for (length = 1;
+            col + length < run_end && covered[col + length] < row;
+            length++);
+
+        if (length >= 3)
+        {
+          found.push_back(FieldPattern(i, length, field[i]));
+          inner_until = col + length;
+        }
       }
 
-      winning_regions->push_back(FieldPattern(i, type, colour));
-    }
+      // vertical: upwards, while still the same colour.
+      top = pending[col] >= 0 ? pending[col] : vrun[i] ? row + vrun[i] - 1 : -1;
 
-    // vertical: -row:above, 0:this, +row:below
-    if (i <= (this->size - 2*this->rows) && colour > 0
-        && colour_at(row+1, col) == colour && colour_at(row+2, col) == colour
-        && colour_at(row-1, col) != colour)  // avoid overlapping
-    {
-      int type = -3;
+      if (top < 0) continue;
 
-      // act, like it's deleted later
-      this->set(row + 0,col, 0);
-      this->set(row + 1,col, 0);
-      this->set(row + 2,col, 0);
+      waiting -= pending[col] >= 0;
+      pending[col] = -1;
 
-      // increase pattern, if still on same row (!= -1)
-      while (colour_at(row - type,col) == colour)
+      if (!inner && top - row >= 2)
       {
-        this->set(row - type,col, 0);
-        type -= 1;
+        found.push_back(FieldPattern(i, -(top - row + 1), field[i]));
+        covered[col] = top;
+      }
+      else if (inner && top - row >= 3)  // may start above the inner cell.
+      {
+        pending[col] = top;
+        waiting ++;
       }
-
-      winning_regions->push_back(FieldPattern(i, type, colour));
     }
   }
 
-  this->field = backup;  // restore backup.
-
-  /* Unique */
-  return winning_regions;
+  return found.size();
 }
 
 void Field::remove_pattern(FieldPattern p, bool auto_gravity)
@@ -401,7 +742,14 @@ void Field::remove_patterns(std::vector<FieldPattern> *pattern, bool auto_gravit
 {
   if (pattern == NULL) return;
 
-  for (FieldPattern p : *pattern)
+  this->remove_patterns(*pattern, auto_gravity);
+
+  delete pattern;
+}
+
+void Field::remove_patterns(const std::vector<FieldPattern> &pattern, bool auto_gravity)
+{
+  for (FieldPattern p : pattern)
   {
     this->remove_pattern(p, false);
   }
@@ -410,8 +758,46 @@ void Field::remove_patterns(std::vector<FieldPattern> *pattern, bool auto_gravit
   {
     this->fix_gavity();
   }
+}
 
-  delete pattern;
+int Field::make_move(int index, int colour, FieldUndo &undo,
+    std::vector<FieldPattern> &removed)
+{
+  int steps = 0;
+
+  undo.moves.push_back(undo.changes.size());
+  this->recording = &undo;
+
+  this->insert(index, colour);
+
+  for (; this->search_patterns(move_patterns); steps++)
+  {
+    removed.insert(removed.end(), move_patterns.begin(), move_patterns.end());
+    this->remove_patterns(move_patterns);  // gravity once.
+  }
+
+  this->recording = NULL;
+
+  return steps;
+}
+
+/**
+ * Set the changed cells back, latest first.
+ * Runs are rescanned only there, like after any other change.
+ */
+void Field::unmake_move(FieldUndo &undo)
+{
+  if (undo.moves.empty()) return;
+
+  long unsigned int first = undo.moves.back();
+
+  for (long unsigned int i = undo.changes.size(); i > first; i--)
+  {
+    this->set(undo.changes[i-1].index, undo.changes[i-1].colour);
+  }
+
+  undo.changes.erase(undo.changes.begin() + first, undo.changes.end());
+  undo.moves.pop_back();
 }
 
 #endif
@@ -0,0 +1,342 @@
+#ifndef _FIELD_BACKEND_H_
+#define _FIELD_BACKEND_H_
+
+#include <climits>
+#include <iostream>
+#include <vector>
+
+#include "field.h"
+#include "random.h"
+
+/**
+ * Rules shared by the field backends (BitField, ColumnField, PackedField,
+ * FixedField), which only differ in how they store their cells.
+ * The Board derives from FieldBackend<Board> and provides get_rows(),
+ * get_cols(), get_size(), name(), and the unchecked cell(row, col) and
+ * put(row, col, colour), which returns the old colour, and
+ * search_scratch(), get_cols() ints for the search.
+ * It may hide max_colour(), push_top(), fix_gavity() and
+ * search_patterns(found) with its own versions.
+ */
+template <class Board>
+class FieldBackend
+{
+  private:
+    Board &board() { return static_cast<Board &>(*this); }
+
+  protected:
+    int max_colour() { return INT_MAX; }  // greatest storable colour.
+
+    int set(int row, int col, int colour);  // return old field, -1: invalid.
+    int set(int index, int colour);  // return old field, -1: invalid.
+
+    void push_top(int col, int colour);  // insert on top of that column.
+
+  public:
+    int get_bounds_max();  // maximum positions for colour insertion.
+
+    void start(int field_variety = 7);  // number of different colours
+    void start(int field_variety, Random &random);  // drawn from random.
+    void start(std::vector<int> starting_fields);
+
+    int colour_at(int index);
+    int colour_at(int row, int col);
+
+    void insert(int index, int colour);
+    void fix_gavity(); // fill all gaps, if something is above.
+
+    std::vector<FieldPattern> *search_patterns();
+    int search_patterns(std::vector<FieldPattern> &found);
+
+    void remove_pattern(FieldPattern pattern, bool auto_gravity = true);
+    void remove_patterns(std::vector<FieldPattern> *pattern, bool auto_gravity = true);
+    void remove_patterns(const std::vector<FieldPattern> &pattern, bool auto_gravity = true);
+};
+
+template <class Board>
+int FieldBackend<Board>::get_bounds_max()
+{
+  return board().get_rows() * 2 + board().get_cols();
+}
+
+/**
+ * Start with random setup, not to be replayed.
+ */
+template <class Board>
+void FieldBackend<Board>::start(int field_variety)
+{
+  Random random(random_seed());
+  this->start(field_variety, random);
+}
+
+/**
+ * Start with random setup, drawn from the given engine.
+ */
+template <class Board>
+void FieldBackend<Board>::start(int field_variety, Random &random)
+{
+  if (field_variety > board().max_colour()) field_variety = board().max_colour();
+
+  for (int i = 0; i < board().get_size(); i++)
+  {
+    this->set(i, 1 + random.below(field_variety));
+  }
+}
+
+template <class Board>
+void FieldBackend<Board>::start(std::vector<int> starting_fields)
+{
+  int i = 0;
+  for (const int f : starting_fields)
+  {
+    this->set(i++, f);
+  }
+}
+
+/* Index is row by row, like in Field, whatever the storage is. */
+template <class Board>
+int FieldBackend<Board>::colour_at(int index)
+{
+  if (index < 0 || index >= board().get_size())
+  {
+    return -1; // invalid index, invalid colour.
+  }
+  return board().cell(index / board().get_cols(), index % board().get_cols());
+}
+
+template <class Board>
+int FieldBackend<Board>::colour_at(int row, int col)
+{
+  if (row < 0 || col < 0 || row >= board().get_rows() || col >= board().get_cols())
+    return -1; // invalid.
+  return board().cell(row, col);
+}
+
+/* Like Field::set(), but colours, which the board can not store, are
+ * rejected as well: nothing is changed and -1 returned, so no insertion
+ * pushes them on. */
+template <class Board>
+int FieldBackend<Board>::set(int index, int colour)
+{
+  if (colour < 0 || colour > board().max_colour())
+  {
+    std::cerr << board().name() << "::set("<<(index)<<", "<<(colour)<<") "
+      << "- Invalid colour." << std::endl;
+    return -1;
+  }
+  else if (index >= 0 && index < board().get_size())
+  {
+    int cols = board().get_cols();
+    return board().put(index / cols, index % cols, colour);
+  }
+  else
+  {
+    std::cerr << board().name() << "::set("<<(index)<<", "<<(colour)<<") "
+      << "- Invalid arguments." << std::endl;
+    return -1;  // invalid index, invalid colour
+  }
+}
+
+template <class Board>
+int FieldBackend<Board>::set(int row, int col, int colour)
+{
+  if (row < 0 || col < 0 || row >= board().get_rows() || col >= board().get_cols())
+    return -1; // invalid.
+  return this->set(row * board().get_cols() + col, colour);
+}
+
+/* Push the column down, the bottom may fall out. */
+template <class Board>
+void FieldBackend<Board>::push_top(int col, int colour)
+{
+  for (int row = board().get_rows() - 1; row >= 0 && colour > 0; row--)
+  {
+    colour = this->set(row, col, colour);
+  }
+}
+
+/**
+ * Pos starts (0) left, row (0) and goes clockwise, like Field::insert().
+ */
+template <class Board>
+void FieldBackend<Board>::insert(int index, int colour)
+{
+  if (colour < 1 || colour > board().max_colour()) return;  // invalid colour.
+  if (index < 0) return;  // invalid position
+
+  int rows = board().get_rows(), cols = board().get_cols();
+  int waiting = colour;
+
+  // [left] ++ [top] ++ [right]
+  int left_end = rows;
+  int cols_end = left_end + cols;
+  int right_end = cols_end + rows;
+
+  if (index < left_end)  // insert left
+  {
+    for (int col = 0; col < cols && waiting > 0; col++)
+    {
+      waiting = this->set(index, col, waiting);
+    }
+  }
+  else if (index < cols_end)  // insert top
+  {
+    board().push_top(index - left_end, waiting);
+  }
+  else if (index < right_end)  // insert right
+  {
+    int row = rows - index + cols_end - 1;
+
+    for (int col = cols - 1; col >= 0 && waiting > 0; col--)
+    {
+      waiting = this->set(row, col, waiting);
+    }
+  }
+  else
+  {
+    std::cerr
+      << "[Error] Tried to insert on "
+      << "invalid insertion position (" << index << ")" << std::endl;
+    return;
+  }
+
+  board().fix_gavity();
+}
+
+/* Let every column fall down in one pass. */
+template <class Board>
+void FieldBackend<Board>::fix_gavity()
+{
+  int rows = board().get_rows(), cols = board().get_cols();
+
+  for (int col = 0; col < cols; col++)
+  {
+    int bottom = 0;  // next free row from below.
+
+    for (int row = 0, colour; row < rows; row++)
+    {
+      if (!(colour = board().cell(row, col))) continue;
+
+      if (bottom != row)
+      {
+        board().put(bottom, col, colour);
+        board().put(row, col, 0);
+      }
+      bottom ++;
+    }
+  }
+}
+
+template <class Board>
+std::vector<FieldPattern> *FieldBackend<Board>::search_patterns()
+{
+  std::vector<FieldPattern> *winning_regions = new std::vector<FieldPattern>();
+  board().search_patterns(*winning_regions);
+  return winning_regions;
+}
+
+/**
+ * Like Field::search_patterns(), by the board's unchecked cells.
+ * A cell belongs to at most one pattern, the first found (like removed):
+ * Cells of a vertical pattern are skipped in the rows above,
+ * inner cells of a horizontal pattern can not start a vertical one.
+ */
+template <class Board>
+int FieldBackend<Board>::search_patterns(std::vector<FieldPattern> &found)
+{
+  int rows = board().get_rows(), cols = board().get_cols();
+  int colour, length, inner_until;
+
+  // per column: top row of a vertical pattern.
+  int *covered = board().search_scratch();
+
+  found.clear();
+  for (int col = 0; col < cols; col++) covered[col] = -1;
+
+  for (int row = 0; row < rows; row++)
+  {
+    inner_until = 0;  // first column after the current horizontal pattern.
+
+    for (int col = 0; col < cols; col++)
+    {
+      colour = board().cell(row, col);
+
+      if (colour < 1 || covered[col] >= row) continue;  // empty or taken.
+
+      bool inner = col < inner_until;
+
+      // horizontal: only from the first free cell of that colour.
+      if (!inner && (col == 0 || covered[col-1] >= row
+            || board().cell(row, col-1) != colour))
+      {
+        for (length = 1;
+            col + length < cols && covered[col + length] < row
+            && board().cell(row, col + length) == colour;
+            length++);
+
+        if (length >= 3)
+        {
+          found.push_back(FieldPattern(row*cols + col, length, colour));
+          inner_until = col + length;
+        }
+      }
+
+      // vertical: upwards, while still the same colour.
+      if (!inner && row + 2 < rows
+          && board().cell(row + 1, col) == colour
+          && board().cell(row + 2, col) == colour)
+      {
+        for (length = 3;
+            row + length < rows && board().cell(row + length, col) == colour;
+            length++);
+
+        found.push_back(FieldPattern(row*cols + col, -length, colour));
+        covered[col] = row + length - 1;
+      }
+    }
+  }
+
+  return found.size();
+}
+
+template <class Board>
+void FieldBackend<Board>::remove_pattern(FieldPattern p, bool auto_gravity)
+{
+  for (int i : p.cells(board().get_cols()))
+  {
+    this->set(i, 0);
+  }
+
+  if (auto_gravity)
+  {
+    board().fix_gavity();
+  }
+}
+
+template <class Board>
+void FieldBackend<Board>::remove_patterns(
+    std::vector<FieldPattern> *pattern, bool auto_gravity)
+{
+  if (pattern == NULL) return;
+
+  this->remove_patterns(*pattern, auto_gravity);
+
+  delete pattern;
+}
+
+template <class Board>
+void FieldBackend<Board>::remove_patterns(
+    const std::vector<FieldPattern> &pattern, bool auto_gravity)
+{
+  for (FieldPattern p : pattern)
+  {
+    this->remove_pattern(p, false);
+  }
+
+  if (auto_gravity)
+  {
+    board().fix_gavity();
+  }
+}
+
+#endif // _FIELD_BACKEND_H_
@@ -0,0 +1,98 @@
+#ifndef _FIELD_KERNEL_H_
+#define _FIELD_KERNEL_H_
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define FIELD_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+/* Run detection kernel for Field.
+ *
+ * Find the first j in [from, n), where a[j] is a colour (> 0),
+ * and b[j] and c[j] have the same colour.
+ * - Row of three: a = row, b = row + 1, c = row + 2, n = cols - 2.
+ * - Column of three: a, b, c = three rows above each other, n = cols.
+ * Return n, if there is none.
+ *
+ * SSE2 compares 4 and AVX2 8 cells per instruction, the instruction set is
+ * chosen at runtime, the scalar loop is used everywhere else. */
+
+typedef int (*triple_finder)(
+    const int *a, const int *b, const int *c, int n, int from);
+
+int find_triple_scalar(const int *a, const int *b, const int *c, int n, int from)
+{
+  for (int j = from; j < n; j++)
+  {
+    if (a[j] > 0 && a[j] == b[j] && a[j] == c[j]) return j;
+  }
+  return n;
+}
+
+#ifdef FIELD_KERNEL_X86
+
+__attribute__((target("sse2")))
+int find_triple_sse2(const int *a, const int *b, const int *c, int n, int from)
+{
+  int j = from;
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; j + 4 <= n; j += 4)
+  {
+    __m128i x = _mm_loadu_si128((const __m128i *) (a + j));
+    __m128i y = _mm_loadu_si128((const __m128i *) (b + j));
+    __m128i z = _mm_loadu_si128((const __m128i *) (c + j));
+
+    __m128i same = _mm_and_si128(_mm_cmpeq_epi32(x, y), _mm_cmpeq_epi32(x, z));
+    same = _mm_and_si128(same, _mm_cmpgt_epi32(x, zero));
+
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(same));
+    if (mask) return j + __builtin_ctz(mask);
+  }
+
+  return find_triple_scalar(a, b, c, n, j);  // tail.
+}
+
+__attribute__((target("avx2")))
+int find_triple_avx2(const int *a, const int *b, const int *c, int n, int from)
+{
+  int j = from;
+  const __m256i zero = _mm256_setzero_si256();
+
+  for (; j + 8 <= n; j += 8)
+  {
+    __m256i x = _mm256_loadu_si256((const __m256i *) (a + j));
+    __m256i y = _mm256_loadu_si256((const __m256i *) (b + j));
+    __m256i z = _mm256_loadu_si256((const __m256i *) (c + j));
+
+    __m256i same
+      = _mm256_and_si256(_mm256_cmpeq_epi32(x, y), _mm256_cmpeq_epi32(x, z));
+    same = _mm256_and_si256(same, _mm256_cmpgt_epi32(x, zero));
+
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(same));
+    if (mask) return j + __builtin_ctz(mask);
+  }
+
+  return find_triple_scalar(a, b, c, n, j);  // tail.
+}
+
+#endif // FIELD_KERNEL_X86
+
+/* Best kernel for this machine. */
+triple_finder select_triple_finder()
+{
+#ifdef FIELD_KERNEL_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return find_triple_avx2;
+  if (__builtin_cpu_supports("sse2")) return find_triple_sse2;
+#endif
+  return find_triple_scalar;
+}
+
+int find_triple(const int *a, const int *b, const int *c, int n, int from = 0)
+{
+  static const triple_finder finder = select_triple_finder();
+  return finder(a, b, c, n, from);
+}
+
+#endif // _FIELD_KERNEL_H_
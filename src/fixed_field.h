@@ -0,0 +1,81 @@
+#ifndef _FIXED_FIELD_H_
+#define _FIXED_FIELD_H_
+
+#include <array>
+#include <iostream>
+#include <vector>
+
+#include "field.h"
+#include "field_backend.h"
+
+/* Field backend with the dimensions fixed at compile time.
+ * Cells and search scratch are std::arrays, so it lives on the stack and
+ * a copy allocates nothing; all index maths is constexpr, so loops over a
+ * small board can be unrolled.
+ * Only a standalone backend: Game and the players still use Field. */
+template <int Rows, int Cols>
+class FixedField : public FieldBackend<FixedField<Rows, Cols>>
+{
+  static_assert(Rows > 0 && Cols > 0, "FixedField needs at least one cell.");
+
+  friend class FieldBackend<FixedField<Rows, Cols>>;
+
+  private:
+    std::array<int, Rows * Cols> field;
+    std::array<int, Cols> covered;  // search scratch.
+
+    static const char *name() { return "FixedField"; }
+
+    int *search_scratch();
+
+    int cell(int row, int col);  // unchecked.
+    int put(int row, int col, int colour);  // unchecked, return old field
+
+  public:
+    static constexpr int ROWS = Rows;
+    static constexpr int COLS = Cols;
+    static constexpr int SIZE = Rows * Cols;
+
+    // only for the same interface as Field, must be Rows and Cols.
+    FixedField(int rows = Rows, int cols = Cols);
+
+    static constexpr int index_of(int row, int col) { return row * Cols + col; }
+
+    constexpr int get_size() const { return SIZE; }
+    constexpr int get_rows() const { return Rows; }
+    constexpr int get_cols() const { return Cols; }
+};
+
+template <int Rows, int Cols>
+FixedField<Rows, Cols>::FixedField(int rows, int cols)
+{
+  if (rows != Rows || cols != Cols)
+  {
+    std::cerr << "FixedField<"<<(Rows)<<", "<<(Cols)<<">("
+      <<(rows)<<", "<<(cols)<<") - Invalid dimensions, ignored." << std::endl;
+  }
+  this->field.fill(0);
+  this->covered.fill(-1);
+}
+
+template <int Rows, int Cols>
+int *FixedField<Rows, Cols>::search_scratch()
+{
+  return this->covered.data();
+}
+
+template <int Rows, int Cols>
+int FixedField<Rows, Cols>::cell(int row, int col)
+{
+  return this->field[index_of(row, col)];
+}
+
+template <int Rows, int Cols>
+int FixedField<Rows, Cols>::put(int row, int col, int colour)
+{
+  int old = this->field[index_of(row, col)];
+  this->field[index_of(row, col)] = colour;
+  return old;
+}
+
+#endif // _FIXED_FIELD_H_
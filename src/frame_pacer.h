@@ -0,0 +1,100 @@
+#ifndef _FRAME_PACER_H_
+#define _FRAME_PACER_H_
+
+#include <climits>
+
+/**
+ * Schedules frames for a target frame rate, only if something changed.
+ * The loop asks, how long it may sleep: until the next frame slot, if a
+ * frame is requested, until the earliest requested wakeup (an animation
+ * step), else as long as no input comes (-1).
+ * All times in milliseconds, of any monotonic clock.
+ */
+class FramePacer
+{
+  private:
+    int fps;
+    long frame_ms;
+    long next_frame = 0;  // earliest start of the next frame.
+    long wakeup = LONG_MAX;  // earliest requested wakeup, LONG_MAX: none.
+    bool requested = true;  // the first frame is always drawn.
+    long frames = 0;
+
+  public:
+    FramePacer(int fps = 60);
+
+    void set_fps(int fps);
+    int get_fps();
+
+    /* Something changed: draw the next frame slot. */
+    void request_frame();
+
+    /* Wake up at that time (at the latest), to update an animation. */
+    void request_wakeup(long at);
+
+    /* Milliseconds to sleep (-1: until an event), forget the wakeup. */
+    long get_timeout(long now);
+
+    /* Return true, if a frame is to be drawn now; then it is scheduled. */
+    bool begin_frame(long now);
+
+    /* Frames drawn so far. */
+    long count_frames();
+};
+
+FramePacer::FramePacer(int fps)
+{
+  this->set_fps(fps);
+}
+
+void FramePacer::set_fps(int fps)
+{
+  this->fps = fps < 1 ? 1 : fps > 1000 ? 1000 : fps;
+  this->frame_ms = 1000 / this->fps;
+}
+
+int FramePacer::get_fps()
+{
+  return this->fps;
+}
+
+void FramePacer::request_frame()
+{
+  this->requested = true;
+}
+
+void FramePacer::request_wakeup(long at)
+{
+  if (at < wakeup) this->wakeup = at;
+}
+
+long FramePacer::get_timeout(long now)
+{
+  long until = requested && next_frame < wakeup ? next_frame : wakeup;
+
+  this->wakeup = LONG_MAX;
+
+  if (until == LONG_MAX) return -1;  // nothing to do, but to wait.
+
+  return until > now ? until - now : 0;
+}
+
+bool FramePacer::begin_frame(long now)
+{
+  if (!requested || now < next_frame) return false;
+
+  /* Keep the rhythm, unless a frame was late; never catch up on frames. */
+  this->next_frame
+    = now - next_frame < frame_ms ? next_frame + frame_ms : now + frame_ms;
+  this->requested = false;
+  this->frames ++;
+
+  return true;
+}
+
+long FramePacer::count_frames()
+{
+  return this->frames;
+}
+
+#endif // _FRAME_PACER_H_
@@ -5,8 +5,111 @@
 #include <vector>
 
 #include "field.h"
+#include "random.h"
+#include "replay.h"
+#include "ring_queue.h"
 // #include "blob_handler.h"
 
+/* One cascade step: all patterns found at once, removed before gravity. */
+class CascadeStep
+{
+  public:
+    int depth;  // 0: patterns of the insertion itself, 1: first combo, ...
+    int first;  // index of the first pattern in CascadeLog::patterns.
+    int count;  // number of patterns in this step.
+    int score;  // summed score of this step.
+
+    CascadeStep(int depth, int first, int count, int score)
+      : depth(depth), first(first), count(count), score(score)
+    {}
+};
+
+/* Log of a resolved cascade, to be animated afterwards. Reusable. */
+class CascadeLog
+{
+  public:
+    std::vector<FieldPattern> patterns;  // all steps, in removal order.
+    std::vector<int> scores;  // score per pattern.
+    std::vector<CascadeStep> steps;
+    int total_score = 0;
+
+    void clear()
+    {
+      patterns.clear();
+      scores.clear();
+      steps.clear();
+      total_score = 0;
+    }
+
+    /* Number of steps, which followed the first one. */
+    int combo_depth()
+    {
+      return steps.size() < 2 ? 0 : steps.size() - 1;
+    }
+};
+
+/* State of a game before a made move, which the field does not keep. */
+class GameMove
+{
+  public:
+    int score[2];
+    int blobs[2];
+    bool player1;
+    int colour;  // inserted colour, popped from the waiting list.
+    int first;  // index of its first pattern in GameUndo::patterns.
+    Random random;  // before drawing the new waiting colour.
+};
+
+/* Undo log of made game moves. Reusable. */
+class GameUndo
+{
+  public:
+    FieldUndo field;
+    std::vector<GameMove> moves;
+    std::vector<FieldPattern> patterns;  // removed patterns of all moves.
+
+    void clear()
+    {
+      field.clear();
+      moves.clear();
+      patterns.clear();
+    }
+
+    int count_moves()
+    {
+      return moves.size();
+    }
+};
+
+/* Everything, which changes in a turn, to jump between turns. */
+class GameState
+{
+  public:
+    std::vector<int> cells;
+    int score[2];
+    int blobs[2];
+    bool player1;
+    std::vector<int> waiting;  // colours waiting.
+    Random random;
+};
+
+/* Writer of a game's replay, which is not copied: a copy of a game (or a
+ * game assigned from another one) records nothing. */
+class GameRecorder
+{
+  public:
+    ReplayWriter *writer = NULL;
+
+    GameRecorder() {}
+    GameRecorder(const GameRecorder &) {}
+
+    GameRecorder &operator=(const GameRecorder &)
+    {
+      this->writer = NULL;
+      return *this;
+    }
+};
+
 class Game
 {
   private:
@@ -14,6 +117,10 @@ class Game
     Field field;
     int colours;  // count of different colours.
 
+    // draws the field and the waiting colours, copied with the game.
+    uint64_t seed;
+    Random random;
+
     // players and scores.
     int score[2] = {0, 0};
     int blobs[2] = {0, 0};
@@ -24,23 +131,32 @@ class Game
     bool player1 = true;  // indicates, it is player 0's turn
     long unsigned int insert_index; // index for insertion.
     long unsigned int waiting_size;  // size of colour waiting list "colours_waiting".
-    std::vector<int> colours_waiting;  // waiting list for the colours.
+    RingQueue<int> colours_waiting;  // waiting list for the colours.
 
-    // removing patterns: step by step
-    std::vector<FieldPattern> *waiting_patterns;
+    // removing patterns: step by step, from the queue; found: search scratch.
+    RingQueue<FieldPattern> waiting_patterns;
+    std::vector<FieldPattern> found_patterns;
 
     std::vector<long unsigned int> colour_scores;
 
+    // records turns: inserted by insert_colour(), written by new_colour().
+    GameRecorder recorder;
+    int recorded_colour = 0;  // 0: no turn to write.
+    int recorded_index;
+    std::vector<int> recorded_queued;
+
   public:
     /* Create a new game.
      * Field dimension:  rows*cols.
      * Colour count: colours.
      * Summing Blob count: blobs.
      * Size of colour waiting list: colours_waiting.
+     * Random seed, the same seed plays the same colours.
      */
-    Game(int rows=5, int cols=5, int colours=5, int blobs=10, int waiting=3);
+    Game(int rows=5, int cols=5, int colours=5, int blobs=10, int waiting=3,
+        uint64_t seed = random_seed());
 
-    /* Clear the lists. Print the last winner.*/
+    /* Clear the lists.*/
     ~Game();
 
     /* Get the game field. ATTENTION: Changes will apply in the game. */
@@ -49,6 +165,27 @@ class Game
 
     void set_colour_score(long unsigned int  colour, int score);
 
+    /* Get the seed, the game was started with. */
+    uint64_t get_seed();
+
+    /* Restart the random engine, e.g. before start(), to replay a game. */
+    void set_seed(uint64_t seed);
+
+    /* Copy the state of the field, scores, blobs, player and colours. */
+    void get_state(GameState &state);
+
+    /* Continue from a state of a game with the same setup. */
+    void set_state(const GameState &state);
+
+    /* Record the setup and every following turn, NULL: stop recording.
+     * Set before start(), so the seed starts the recorded game.
+     * Copies of this game do not record. */
+    void set_recorder(ReplayWriter *recorder);
+
+    /* Key of this position for a TranspositionTable:
+     * the field hash, the waiting colours and the player to move. */
+    uint64_t get_hash();
+
     /* Start the game, player 0 starts.. */
     void start();
 
@@ -61,9 +198,15 @@ class Game
     /* Get current player.  Return player (0/false) and player (1/true). */
     bool get_current_player();
 
+    /* Check if one player has all blobs. */
+    bool is_over();
+
     /* Get the player who currently has all blobs or the highest score. */
     bool get_current_winner();
 
+    /* Get the number of different colours, new colours are drawn from. */
+    int count_colours();
+
     /* Get the current colour which will be inserted. */
     int get_waiting_colour(int i = 0);
 
@@ -87,12 +230,31 @@ class Game
     /* Check if the game has patterns, which are about to be removed. */
     bool has_waiting_patterns();
 
-    /* Get the indices of the first pattern, if there are patterns waiting. */
-    std::vector<int> *get_first_pattern();
+    /* Get the indices of the first pattern, empty if none is waiting.
+     * A view, valid until the pattern is removed; nothing to free. */
+    PatternCells get_first_pattern();
 
-    /* Remove the first pattern of the waiting list, return its value.*/
+    /* Remove the first pattern of the waiting list, return its value.
+     * Gravity is applied, when the last waiting pattern is removed. */
     int remove_first_pattern();
 
+    /* Get the score of a pattern: colour score times (size - 2). */
+    int get_pattern_score(FieldPattern p);
+
+    /* Remove all patterns at once, apply gravity, repeat until none is left.
+     * Every pattern scores for the current player. Return the summed score. */
+    int resolve_cascade(CascadeLog &log);
+
+    /* Whole turn: insert, resolve cascade, next player and next colour. */
+    int play_turn(CascadeLog &log);
+
+    /* Whole turn at that insertion index, like play_turn(), but logged into
+     * undo instead of a cascade log. Return the score of the move. */
+    int make_move(int index, GameUndo &undo);
+
+    /* Restore the game before the last move of undo, without copying. */
+    void unmake_move(GameUndo &undo);
+
     /* Add score to the given player. */
     void add_score(bool player1, int score);
 
@@ -110,25 +272,25 @@ class Game
 //-----------------------------------------------------------------------------
 //new game and end game
 
-Game::Game(int rows, int cols, int colours, int blobs, int waiting_size)
+Game::Game(int rows, int cols, int colours, int blobs, int waiting_size,
+    uint64_t seed)
+  : seed(seed), random(seed)
 {
   /* Don't allow values, smaller than 1.*/
   this->field.resize(rows < 1 ? 1 : rows, cols < 1 ? 1 : cols);
   this->colours = colours < 1 ? 1 : colours;
   this->waiting_size = waiting_size < 1 ? 1 : waiting_size;
   this->blobs_size = blobs < 2 ? 2 : blobs;
+
+  // no turn needs more: one cell belongs to at most one pattern of three.
+  this->colours_waiting = RingQueue<int>(this->waiting_size);
+  this->waiting_patterns = RingQueue<FieldPattern>(field.get_size() / 3 + 1);
+  this->found_patterns.reserve(field.get_size() / 3 + 1);
+  this->recorded_queued.reserve(this->waiting_size);
 }
 
 Game::~Game()
 {
-  if (waiting_patterns)
-  {
-    delete waiting_patterns;
-    waiting_patterns = NULL;
-  }
-
-  // print the last winner.
-  std::cout << "WINNER: Player " << (get_current_winner()) << std::endl;
 }
 
 Field *Game::get_field()
@@ -145,13 +307,93 @@ void Game::set_colour_score(long unsigned int colour, int score)
   this->colour_scores[colour] = score < 0 ? 0 : score;
 }
 
+uint64_t Game::get_seed()
+{
+  return this->seed;
+}
+
+void Game::set_seed(uint64_t seed)
+{
+  this->seed = seed;
+  this->random.seed(seed);
+}
+
+void Game::get_state(GameState &state)
+{
+  state.cells.resize(field.get_size());
+  for (int i = 0; i < field.get_size(); i++)
+  {
+    state.cells[i] = field.colour_at(i);
+  }
+
+  state.score[0] = score[0];
+  state.score[1] = score[1];
+  state.blobs[0] = blobs[0];
+  state.blobs[1] = blobs[1];
+  state.player1 = player1;
+  state.waiting.clear();
+  for (long unsigned int i = 0; i < colours_waiting.size(); i++)
+  {
+    state.waiting.push_back(colours_waiting[i]);
+  }
+  state.random = random;
+}
+
+void Game::set_state(const GameState &state)
+{
+  this->field.start(state.cells);
+
+  this->score[0] = state.score[0];
+  this->score[1] = state.score[1];
+  this->blobs[0] = state.blobs[0];
+  this->blobs[1] = state.blobs[1];
+  this->player1 = state.player1;
+  this->colours_waiting.clear();
+  for (int colour : state.waiting) this->colours_waiting.push_back(colour);
+  this->random = state.random;
+
+  this->waiting_patterns.clear();
+  this->recorded_colour = 0;
+}
+
+void Game::set_recorder(ReplayWriter *recorder)
+{
+  this->recorder.writer = recorder;
+  this->recorded_colour = 0;
+
+  if (!recorder) return;
+
+  ReplayHeader header;
+  header.rows = field.get_rows();
+  header.cols = field.get_cols();
+  header.colours = colours;
+  header.blobs = blobs_size;
+  header.waiting = waiting_size;
+  header.seed = seed;
+
+  recorder->write_header(header);
+}
+
+uint64_t Game::get_hash()
+{
+  uint64_t hash = this->field.get_hash();
+
+  // waiting colours and the player use indices below the field (negative).
+  for (long unsigned int i = 0; i < colours_waiting.size(); i++)
+  {
+    hash ^= zobrist_key(-2 - i, colours_waiting[i]);
+  }
+
+  return player1 ? hash ^ zobrist_key(-1, 1) : hash;
+}
+
 //-----------------------------------------------------------------------------
 // switch turns and get new colours.
 
 void Game::start()
 {
   /* fill field */
-  this->field.start(this->colours);  // field_variety := colours
+  this->field.start(this->colours, random);  // field_variety := colours
 
   /* set insertion colour */
   if (!this->colours_waiting.size())
@@ -160,16 +402,9 @@ void Game::start()
   this->insert_index = 0;
 
   /* Remove possible first field pattern (no points) */
-  waiting_patterns = field.search_patterns();
-  while (waiting_patterns->size())
+  while (field.search_patterns(found_patterns))
   {
-    field.remove_patterns(waiting_patterns);
-    waiting_patterns = field.search_patterns();
-  }
-  if (waiting_patterns)
-  {
-    delete waiting_patterns;
-    waiting_patterns = NULL;
+    field.remove_patterns(found_patterns);
   }
 
   this->player1 = false;
@@ -183,14 +418,26 @@ void Game::start()
 
 void Game::new_colour()
 {
-  if (colours_waiting.size())
+  this->colours_waiting.pop_front();
+
+  long unsigned int queued = colours_waiting.size();
+
+  while (colours_waiting.size() < waiting_size)
   {
-    this->colours_waiting.erase(colours_waiting.begin());
+    this->colours_waiting.push_back(random.below(this->colours) + 1);
   }
 
-  while (colours_waiting.size() < waiting_size)
+  if (recorder.writer && recorded_colour)  // end of a recorded turn.
   {
-    this->colours_waiting.push_back(rand() % this->colours + 1);
+    this->recorded_queued.clear();
+    for (long unsigned int i = queued; i < colours_waiting.size(); i++)
+    {
+      this->recorded_queued.push_back(colours_waiting[i]);
+    }
+
+    recorder.writer->write_turn(recorded_index, recorded_colour,
+        recorded_queued.data(), recorded_queued.size());
+    this->recorded_colour = 0;
   }
 }
 
@@ -204,6 +451,11 @@ bool Game::get_current_player()
   return this->player1;
 }
 
+bool Game::is_over()
+{
+  return blobs[0] == 0 || blobs[1] == 0;
+}
+
 bool Game::get_current_winner()
 {
   /* Check if someone has all blobs. */
@@ -219,6 +471,11 @@ bool Game::get_current_winner()
 //-----------------------------------------------------------------------------
 //colour inserted, maybe get patterns and update scores.
 
+int Game::count_colours()
+{
+  return this->colours;
+}
+
 int Game::get_waiting_colour(int i)
 {
   return this->colours_waiting[i];  // if not assigned, return 0 == empty.
@@ -261,6 +518,12 @@ void Game::insert_colour()
     this->new_colour();
   }
   this->field.insert(insert_index, colours_waiting[0]);
+
+  if (recorder.writer)
+  {
+    this->recorded_index = insert_index;
+    this->recorded_colour = colours_waiting[0];
+  }
 }
 
 void Game::update_pattern_waiting_list()
@@ -268,12 +531,14 @@ void Game::update_pattern_waiting_list()
   if (has_waiting_patterns())
     return;
 
-  this->waiting_patterns = this->field.search_patterns();
+  this->field.search_patterns(this->found_patterns);
+
+  for (FieldPattern p : found_patterns) this->waiting_patterns.push_back(p);
 }
 
 bool Game::has_waiting_patterns()
 {
-  return waiting_patterns != NULL && this->waiting_patterns->size();
+  return this->waiting_patterns.size();
 }
 
 int Game::remove_first_pattern()
@@ -281,49 +546,135 @@ int Game::remove_first_pattern()
   if (!has_waiting_patterns())  // nothing to remove.
     return 0;
 
-  FieldPattern p = this->waiting_patterns->at(0);
+  FieldPattern p = this->waiting_patterns.front();
+
+  int pattern_score = this->get_pattern_score(p);
+
+  /* Pop the first.*/
+  this->waiting_patterns.pop_front();
+
+  /* Patterns were found together, let them fall together. */
+  this->field.remove_pattern(p, !has_waiting_patterns());
+
+  return pattern_score;
+}
+
+int Game::get_pattern_score(FieldPattern p)
+{
+  if (p.colour < 0 || (long unsigned int) p.colour >= colour_scores.size())
+    return 0;  // no score set.
 
   /* size 3 => 1x score
    * size 4 => 2x score
    * size 5 => 3x score ... */
-  int pattern_score
-    = colour_scores[p.colour] * (p.size() - 2);
-
-  /* Pop the first.*/
-  this->waiting_patterns->erase(this->waiting_patterns->begin());
+  return colour_scores[p.colour] * (p.size() - 2);
+}
 
-  this->field.remove_pattern(p);
+int Game::resolve_cascade(CascadeLog &log)
+{
+  log.clear();
 
-  /* Emptied. */
-  if (!this->waiting_patterns->size())
+  for (int depth = 0; field.search_patterns(found_patterns); depth++)
   {
-    delete waiting_patterns;
-    waiting_patterns = NULL;
+    int first = log.patterns.size(), step_score = 0;
+
+    for (FieldPattern p : found_patterns)
+    {
+      int pattern_score = this->get_pattern_score(p);
+
+      log.patterns.push_back(p);
+      log.scores.push_back(pattern_score);
+      step_score += pattern_score;
+
+      this->add_score_to_current_player(pattern_score);
+    }
+
+    log.steps.push_back(
+        CascadeStep(depth, first, found_patterns.size(), step_score));
+    log.total_score += step_score;
+
+    this->field.remove_patterns(found_patterns);  // gravity once.
   }
 
-  return pattern_score;
+  found_patterns.clear();
+
+  return log.total_score;
 }
 
-std::vector<int> *Game::get_first_pattern()
+int Game::play_turn(CascadeLog &log)
 {
-  if (!has_waiting_patterns()) return NULL;
+  this->insert_colour();
 
-  std::vector<int> *indices;
-  indices = new std::vector<int>();
+  int turn_score = this->resolve_cascade(log);
 
-  FieldPattern p = waiting_patterns->at(0);
+  this->next_turn();
+  this->new_colour();
 
-  int direction = p.is_horizontal() ? 1 : field.get_cols();
-  int start = p.position;
+  return turn_score;
+}
 
-  indices->push_back(start);
+int Game::make_move(int index, GameUndo &undo)
+{
+  if (colours_waiting.size() < 1)
+  {
+    this->new_colour();
+  }
+
+  GameMove move;
+  move.score[0] = score[0];
+  move.score[1] = score[1];
+  move.blobs[0] = blobs[0];
+  move.blobs[1] = blobs[1];
+  move.player1 = player1;
+  move.colour = colours_waiting[0];
+  move.first = undo.patterns.size();
+  move.random = random;
+  undo.moves.push_back(move);
+
+  this->field.make_move(index, move.colour, undo.field, undo.patterns);
+
+  int move_score = 0;
 
-  for (int i = 1; i < p.size(); i++)
+  for (long unsigned int i = move.first; i < undo.patterns.size(); i++)
   {
-    indices->push_back(start + i*direction);
+    int pattern_score = this->get_pattern_score(undo.patterns[i]);
+    this->add_score_to_current_player(pattern_score);
+    move_score += pattern_score;
   }
 
-  return indices;
+  this->next_turn();
+  this->new_colour();
+
+  return move_score;
+}
+
+void Game::unmake_move(GameUndo &undo)
+{
+  if (undo.moves.empty()) return;
+
+  GameMove move = undo.moves.back();
+  undo.moves.pop_back();
+
+  this->field.unmake_move(undo.field);
+  undo.patterns.erase(undo.patterns.begin() + move.first, undo.patterns.end());
+
+  // new_colour() popped the first and appended one.
+  this->colours_waiting.pop_back();
+  this->colours_waiting.push_front(move.colour);
+
+  this->score[0] = move.score[0];
+  this->score[1] = move.score[1];
+  this->blobs[0] = move.blobs[0];
+  this->blobs[1] = move.blobs[1];
+  this->player1 = move.player1;
+  this->random = move.random;
+}
+
+PatternCells Game::get_first_pattern()
+{
+  if (!has_waiting_patterns()) return PatternCells();
+
+  return waiting_patterns.front().cells(field.get_cols());
 }
 
 void Game::add_score(bool player1, int score)
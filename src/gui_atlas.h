@@ -0,0 +1,147 @@
+#ifndef _GUI_ATLAS_H_
+#define _GUI_ATLAS_H_
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "atlas.h"
+#include "bmp.h"
+#include "render.h"
+
+/**
+ * All sprites in one picture: the pictures are loaded, packed and copied
+ * into the atlas once, their transparent colours become the atlas' colour
+ * key (SPRITE_KEY, pink). The pixels are given to the renderer, the frames
+ * of a picture follow each other in the layout's table, row by row.
+ * Without SDL, also for headless rendering.
+ */
+class SpriteAtlas
+{
+  private:
+    class Source
+    {
+      public:
+        std::string name, path;
+        int frame_w, frame_h;
+        bool keyed;  // transparent colour key.
+        int r, g, b;
+    };
+
+    std::vector<Source> sources;
+    AtlasLayout layout;
+    std::vector<uint32_t> pixels;  // 0xRRGGBB, row by row.
+
+  public:
+    /* Add a picture to be packed by build(), cut into frames of that size
+     * (<= 0: the whole picture); keyed: the colour (r, g, b) is transparent. */
+    void add(std::string name, std::string path, int frame_w = 0,
+        int frame_h = 0, bool keyed = false,
+        int r = 0xff, int g = 0x0, int b = 0xff);
+
+    /* Load and pack the pictures into the atlas. */
+    bool build(int max_width = 512);
+
+    const uint32_t *get_pixels();
+    int get_width();
+    int get_height();
+
+    /* Frames of the picture; NULL, if unknown. */
+    const AtlasRect *get_frames(std::string name);
+};
+
+void SpriteAtlas::add(std::string name, std::string path, int frame_w,
+    int frame_h, bool keyed, int r, int g, int b)
+{
+  Source source;
+
+  source.name = name;
+  source.path = path;
+  source.frame_w = frame_w;
+  source.frame_h = frame_h;
+  source.keyed = keyed;
+  source.r = r;
+  source.g = g;
+  source.b = b;
+
+  this->sources.push_back(source);
+}
+
+bool SpriteAtlas::build(int max_width)
+{
+  std::vector<std::vector<uint32_t>> loaded(sources.size());
+
+  this->pixels.clear();
+  this->layout = AtlasLayout();
+
+  for (long unsigned int i = 0; i < sources.size(); i++)
+  {
+    Source &source = sources[i];
+    int w, h;
+
+    if (!read_bmp(source.path, loaded[i], w, h))
+    {
+      std::cerr << "Loading picture '" << source.path << "' failed." << std::endl;
+      return false;
+    }
+
+    layout.add(source.name, w, h, source.frame_w, source.frame_h);
+  }
+
+  if (!layout.pack(max_width))
+  {
+    std::cerr << "Packing the atlas failed: too wide picture." << std::endl;
+    return false;
+  }
+
+  /* Transparent, where no picture is (or where it is transparent). */
+  this->pixels.assign(layout.get_width() * layout.get_height(), SPRITE_KEY);
+
+  for (long unsigned int i = 0; i < sources.size(); i++)
+  {
+    Source &source = sources[i];
+    const AtlasRect &place = layout.get_image(i).rect;
+    uint32_t key = source.r << 16 | source.g << 8 | source.b;
+
+    for (int y = 0; y < place.h; y++)
+    {
+      for (int x = 0; x < place.w; x++)
+      {
+        uint32_t colour = loaded[i][y * place.w + x];
+
+        if (source.keyed && colour == key) continue;
+
+        this->pixels[(place.y + y) * layout.get_width() + place.x + x] = colour;
+      }
+    }
+  }
+
+  return true;
+}
+
+const uint32_t *SpriteAtlas::get_pixels()
+{
+  return this->pixels.data();
+}
+
+int SpriteAtlas::get_width()
+{
+  return this->layout.get_width();
+}
+
+int SpriteAtlas::get_height()
+{
+  return this->layout.get_height();
+}
+
+const AtlasRect *SpriteAtlas::get_frames(std::string name)
+{
+  int image = layout.find(name);
+
+  if (image < 0 || !layout.count_frames()) return NULL;
+
+  return &layout.get_frame(layout.get_image(image).first_frame);
+}
+
+#endif // _GUI_ATLAS_H_
@@ -1,8 +1,8 @@
 #ifndef _BLOB_GUI_HANDLER_H_
-#define _BLOA_GUI_HANDLER_H_
+#define _BLOB_GUI_HANDLER_H_
 
 #include <vector>
-#include "SDL.h"
+#include "render.h"
 
 #define SET_IDLE 0
 #define SET_WALK_RIGHT 1
@@ -113,8 +113,8 @@ class BlobGuiHandler
     int max_frames_y;
     int max_frames_x;
 
-    SDL_Rect recBlobSrc, recBlobPos;
-    SDL_Surface *surfBlob;
+    AtlasRect recBlobSrc;
+    const AtlasRect *frames = NULL;  // set * max_frames_x + frame.
 //-----------------------------------------------------------------------------
   public:
 
@@ -165,29 +165,23 @@ class BlobGuiHandler
       }
     }  // end of reset_all()
 
-    /* Set texture and maximal frames for a blob.*/
-    void set_texture(SDL_Surface *surf,
-        int width, int height = 0,
+    /* Set texture, its frames (row by row, a row per set) and maximal
+     * frames for a blob.*/
+    void set_texture(const AtlasRect *frames,
         int max_frames_x = 1, int max_frames_y = 1)
     {
-      surfBlob = surf;
+      this->frames = frames;
 
-      recBlobSrc.x = 0;
-      recBlobSrc.y = 0;
-      recBlobSrc.w = width;
-      recBlobSrc.h = height > 0 ? height : width;  // square.
+      recBlobSrc = frames[0];
 
-      recBlobPos.x = 0;
-      recBlobPos.y = 0;
-
-      this->bounds = width;
+      this->bounds = recBlobSrc.w;
 
       this->max_frames_x = max_frames_x;
       this->max_frames_y = max_frames_y;
 
       this->update_all_blobs(true);  // start positiona and colour.
 
-    }  // end set_texture(SDL_Surface, int, int, int, int)
+    }  // end set_texture(AtlasRect, int, int)
 
     /* Set blob for player1; return it's final blob count.*/
     int new_blob_for_player(bool p1)
@@ -294,33 +288,50 @@ class BlobGuiHandler
       }
     }  // end update_all_blobs(bool)
 
+    /* Number of blobs. */
+    long unsigned int count_blobs()
+    {
+      return blobs.size();
+    }
+
+    /* Area, the blob is drawn into. */
+    DirtyRect get_blob_area(long unsigned int blob, int pos_y = 0)
+    {
+      return DirtyRect(blob < blobs.size() ? blobs[blob].where() : 0, pos_y,
+          recBlobSrc.w, recBlobSrc.h);
+    }
+
+    /* Frame of the blob, it is drawn with (changes with its look). */
+    int get_blob_frame(long unsigned int blob)
+    {
+      if (blob >= blobs.size()) return -1;
+
+      return blobs_frame_set[blob] * max_frames_x + blobs_frame[blob];
+    }
+
     /* Draw a blob in it's current moment. */
-    void draw_blob(long unsigned int blob, SDL_Surface *screen, int pos_y = 0)
+    void draw_blob(long unsigned int blob, Renderer &renderer, int pos_y = 0)
     {
       if (blob >= blobs.size())
         return;
 
-      if (!screen)
+      if (!frames)
         return;
 
-      recBlobSrc.x = blobs_frame[blob] * recBlobSrc.w;
-      recBlobSrc.y = blobs_frame_set[blob] * recBlobSrc.h;
-
-      recBlobPos.x = blobs[blob].where();
-      // recBlobPos.y = pos_y - (pos_y < recBlobSrc.h ? 0 : recBlobSrc.h);
-      recBlobPos.y = pos_y;
+      recBlobSrc
+        = frames[blobs_frame_set[blob] * max_frames_x + blobs_frame[blob]];
 
-      SDL_BlitSurface(surfBlob, &recBlobSrc, screen, &recBlobPos);
-    }  // draw_blob(int, SDL_Surface*)
+      renderer.draw_sprite(recBlobSrc, blobs[blob].where(), pos_y);
+    }  // draw_blob(int, Renderer&)
 
     /* Draw all blobs in it's current moment.*/
-    void draw_all_blobs(SDL_Surface *screen, int pos_y = 0)
+    void draw_all_blobs(Renderer &renderer, int pos_y = 0)
     {
       for (long unsigned int i = 0; i < blobs.size(); i++)
       {
-        draw_blob(i, screen, pos_y);
+        draw_blob(i, renderer, pos_y);
       }
-    }  // end draw_all_blobs(SDL_Surface*)
+    }  // end draw_all_blobs(Renderer&)
 //-----------------------------------------------------------------------------
 };  // end of class BlobGuiHandler
 
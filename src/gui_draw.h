@@ -0,0 +1,442 @@
+#ifndef _GUI_DRAW_H_
+#define _GUI_DRAW_H_
+
+#include<iostream>
+#include<string>
+
+#include "dirty_regions.h"
+#include "field.h"
+#include "game.h"
+#include "gui_atlas.h"
+#include "gui_blob_handler.h"
+#include "render.h"
+
+/*
+ * Drawing the game with any renderer, without SDL: in the window (gui.h)
+ * or into memory (render_memory.h).
+ */
+
+#define SCREEN_WIDTH 350
+#define SCREEN_HEIGHT 480
+
+#define BLOB_SIZE 32
+#define BLOB_FRAMES 2
+#define BLOB_FRAME_SETS 6
+
+#define FIELD_SIZE 32
+#define FIELD_FRAMES 7
+
+#define NUMBER_WIDTH 19
+#define NUMBER_HEIGHT 32
+
+// ----
+
+const bool DEBUG = false;
+
+const int BLOB_COUNT = 10;
+const int COLOUR_WAITING_LIST = 3;
+
+// ----
+
+int pattern_score(FieldPattern p)
+{
+  int multiplier = p.size() - 2;  // x1 x2 x3 ...
+
+  switch (p.colour)
+  {
+    case 1: return 10*multiplier;
+    case 2: return 20*multiplier;
+    case 3: return 30*multiplier;
+    case 4: return 40*multiplier;
+    case 5: return 70*multiplier;
+    case 6: return 100*multiplier;
+    case 7: return 150*multiplier;
+    default: return 0;
+  }
+}
+
+void set_index(
+    int index,
+    int rows, int cols,
+    int *ltr,  // is_left:4, is_top:2, is_right:1
+    int *bound_top,
+    int *bound_left,
+    int *bound_right,
+    int *display_index = NULL
+    )
+{
+  bool is_left = index < rows;
+  bool is_top = !is_left && index < (rows + cols);
+  bool is_right = !is_left && !is_top && index < rows * 2 + cols;
+
+  *ltr = (is_left << 2) + (is_top << 1) + (is_right);
+
+  /* If index is invalid, set bounds to normal == no wrapping bounds. */
+
+  if (!bound_top || !bound_left || !bound_right)
+  {
+    std::cerr
+      << "Warning: Cannot set bounds. No destionation given." << std::endl;
+    return; // cannot set bounds.
+  }
+
+  /* Set bounds for drawing. in
+   * for (0,-1..bound_top] {
+   *   for ([bound_left,..bound_right);
+   * }
+   */
+  *bound_left = is_left ? -1 : 0;
+  *bound_top = is_top ? - rows - 1 : -rows;
+  *bound_right = is_right ? cols + 1 : cols;
+
+  if (display_index)  // set display_index, if requested.
+  {
+    // display_index indicastes ...
+    *display_index
+      = is_left ? index % rows  // the row (left side)
+      : is_top ? index - rows  // the column (on top)
+      : is_right ? rows*2 + cols - 1 - index  // the row (right side)
+      : -1;
+  }
+}
+
+/* Draw the number, growing to the left of x; digits: frames of 0..9. */
+void display_number(
+    int p,
+    Renderer *renderer, const AtlasRect *digits, int &x, int y)
+{
+  if (p < 0)
+  {
+    return display_number(0, renderer, digits, x, y);
+  }
+
+  if (digits == NULL || renderer == NULL)
+    return;
+
+  int div =  p, mod = 0;
+
+  for (div = p; div > 0 || p == 0; div /= 10)
+  {
+    mod = div % 10;
+    x -= digits[mod].w;
+
+    renderer->draw_sprite(digits[mod], x, y);
+
+    if (!p) break;  // display P:0 at least once.
+  }
+}
+
+/* Draw the given field with the given renderer (colours: frames by
+ * colour).*/
+void display_field(
+    Renderer *renderer,
+    const AtlasRect *colours,
+    Field *field,
+    int index = -1,
+    int insertion_colour = -1,
+    int anchor_x = 0,
+    int anchor_y = 0,
+    int offset = 4)
+{
+  if (!field)
+  {
+    std::cerr << "Cannot draw field: No Field!" << std::endl;
+    return;
+  }
+  if (!renderer || !colours)
+  {
+    std::cerr << "Cannot draw field: No drawing resources!" << std::endl;
+    return;
+  }
+
+  int rows = field->get_rows();
+  int cols = field->get_cols();
+
+  int ltr, bound_top, bound_left, bound_right, i_;
+
+  set_index(insertion_colour < 1 ? -1 : index, rows, cols,
+      &ltr, &bound_top, &bound_left, &bound_right, &i_);
+
+  int x, y;
+
+  for (int r = 0; r > bound_top; r--)
+  {
+    y = anchor_y + (rows+r) * (colours[0].h + offset);
+
+    for (int c = bound_left; c < bound_right; c++)
+    {
+      x = (c) * (colours[0].w + offset) + anchor_x;
+
+      // draw field, if inside of [0,cols) and [0,rows)
+      if (c >= 0 && c < cols && r <= 0 && r > -rows)
+      {
+        // field colour
+        renderer->draw_sprite(colours[field->colour_at(-r, c)], x, y);
+      }
+      // Indicate chosen position (index) for insertion.
+      else if (((ltr & 0b101) && -r == i_)  // left or right, and chosen row
+          || (ltr == 2 && c == i_))  // top, and chosen column
+      {
+
+        if (DEBUG) std::cout
+          << "Insert into LTR:" << (ltr&4) << (ltr&2) << (ltr&1)
+            << ", i'" << i_
+            << ", colour:" << insertion_colour
+            << std::endl;
+
+        // inserting colour
+        renderer->draw_sprite(colours[insertion_colour], x, y);
+      }
+    }
+  }
+}
+
+
+/* Track every slot of the field and its border (as display_field() draws
+ * them), with the colour shown there (-1: none). */
+void track_field(
+    DirtyRegions &dirty,
+    long unsigned int &id,
+    Field *field,
+    int index,
+    int insertion_colour,
+    int anchor_x,
+    int anchor_y,
+    int offset,
+    int size)
+{
+  int rows = field->get_rows();
+  int cols = field->get_cols();
+
+  int ltr, bound_top, bound_left, bound_right, i_;
+
+  set_index(insertion_colour < 1 ? -1 : index, rows, cols,
+      &ltr, &bound_top, &bound_left, &bound_right, &i_);
+
+  for (int r = 0; r >= -rows; r--)
+  {
+    for (int c = -1; c <= cols; c++)
+    {
+      int colour = -1;
+
+      if (r <= bound_top || c < bound_left || c >= bound_right)
+        colour = -1;  // not drawn.
+      else if (c >= 0 && c < cols && r > -rows)
+        colour = field->colour_at(-r, c);
+      else if (((ltr & 0b101) && -r == i_) || (ltr == 2 && c == i_))
+        colour = insertion_colour;
+
+      dirty.track(id++, DirtyRect(
+            c * (size + offset) + anchor_x,
+            anchor_y + (rows + r) * (size + offset),
+            size, size), colour);
+    }
+  }
+}
+
+/* Scores of the pattern's colours (0: none). */
+void set_colour_scores(Game &game)
+{
+  int score[8] = { 0, 10, 20, 30, 40, 70, 100, 150 };
+
+  for (int i = 0; i < 8; i++)
+  {
+    game.set_colour_score(i, score[i]);
+  }
+}
+
+/* Frames of the game's pictures in the atlas. */
+class GameSprites
+{
+  public:
+    const AtlasRect *bg = NULL;
+    const AtlasRect *blobs = NULL;
+    const AtlasRect *colours = NULL;
+    const AtlasRect *numbers = NULL;
+    const AtlasRect *indicator = NULL;
+};
+
+/* Add the game's pictures from the directory to the atlas.
+ * pink (or the numbers' grey) as colour key. */
+void add_game_sprites(SpriteAtlas &atlas, std::string res_dir = "res")
+{
+  atlas.add("blobs", res_dir + "/blobs.bmp", BLOB_SIZE, BLOB_SIZE, true);
+  atlas.add("colours", res_dir + "/field_colours.bmp", FIELD_SIZE, FIELD_SIZE,
+      true);
+  atlas.add("numbers", res_dir + "/numbers.bmp", NUMBER_WIDTH, NUMBER_HEIGHT,
+      true, 0x33, 0x33, 0x33);
+  atlas.add("indicator", res_dir + "/indicator.bmp", NUMBER_WIDTH, NUMBER_HEIGHT,
+      true, 0x33, 0x33, 0x33);
+  atlas.add("bg", res_dir + "/bg_tile.bmp");
+}
+
+/* Find the frames in the built atlas; false, if a picture is missing. */
+bool find_game_sprites(SpriteAtlas &atlas, GameSprites &sprites)
+{
+  sprites.blobs = atlas.get_frames("blobs");
+  sprites.colours = atlas.get_frames("colours");
+  sprites.numbers = atlas.get_frames("numbers");
+  sprites.indicator = atlas.get_frames("indicator");
+  sprites.bg = atlas.get_frames("bg");
+
+  return sprites.blobs && sprites.colours && sprites.numbers
+    && sprites.indicator && sprites.bg;
+}
+
+/* Positions on the screen, for the field's size and the colours' frames. */
+class GameLayout
+{
+  public:
+    int offset = 4;
+    int number_places = 5;
+
+    int anchor_x, anchor_y;  // the field.
+    int blobs_y;
+
+    GameLayout(int rows, int cols, const AtlasRect &colour)
+    {
+      this->anchor_x
+        = (SCREEN_WIDTH - (colour.w+offset)*(cols+2)) / 2
+        + colour.w;
+      this->anchor_y = colour.h * 3.5;
+      this->blobs_y = anchor_y + (rows + 3)*(colour.h + offset) + 2*offset;
+    }
+};
+
+/* Draw everything, the renderer skips what is outside of the clip area. */
+void display_game(
+    Renderer *renderer,
+    const GameSprites &sprites,
+    const GameLayout &layout,
+    Game &game,
+    BlobGuiHandler &blobs_h)
+{
+  const AtlasRect &rcColourSrc = sprites.colours[0];
+  const AtlasRect &rcNumSrc = sprites.numbers[0];
+  int offset = layout.offset;
+  int x;
+
+  /* ===== Draw background. =============================================== */
+  renderer->draw_sprite(sprites.bg[0],
+      layout.anchor_x - (rcColourSrc.w + offset), layout.anchor_y);
+
+  /* ===== Draw the field and the insertion indicator.. =================== */
+  // Update chosen index for display.
+  display_field(
+      renderer, sprites.colours,  // drawing resources.
+      game.get_field(),  // field
+      game.get_index(), game.get_waiting_colour(),  // index to insert colour.
+      layout.anchor_x, layout.anchor_y, offset  // positioning.
+      );
+
+  /* ===== Draw points and blobs. ========================================= */
+  // indicate current player, reuse number rectangle (will be overridden later)
+  x = !game.get_current_player()
+    ? offset + layout.number_places*rcNumSrc.w
+    : SCREEN_WIDTH - offset;
+  for (int i = 0; i < layout.number_places; i ++)
+  {
+    x -= sprites.indicator[0].w;
+    renderer->draw_sprite(sprites.indicator[0], x, offset);
+  }
+
+  x = offset + layout.number_places*rcNumSrc.w;  // it will grow to the left.
+  display_number(game.get_score_of_player(0),
+      renderer, sprites.numbers, x, offset);
+
+  x = SCREEN_WIDTH - offset;  // it will grow to the left.
+  display_number(game.get_score_of_player(1),
+      renderer, sprites.numbers, x, offset);
+
+  // show next insertion colour (waiting list)
+  x = (SCREEN_WIDTH - (rcColourSrc.w+offset)*game.count_colours_waiting())
+    / 2;
+
+  for (long unsigned int i = 0; i < game.count_colours_waiting(); i++)
+  {
+    renderer->draw_sprite(sprites.colours[game.get_waiting_colour(i)],
+        x, offset);
+
+    x += (rcColourSrc.w + offset);
+  }
+
+  // Draw lively blobs.
+  blobs_h.draw_all_blobs(*renderer, layout.blobs_y);
+}
+
+/* Track everything display_game() draws, with what is shown there. */
+void track_game(
+    DirtyRegions &dirty,
+    const GameSprites &sprites,
+    const GameLayout &layout,
+    Game &game,
+    BlobGuiHandler &blobs_h)
+{
+  const AtlasRect &rcColourSrc = sprites.colours[0];
+  const AtlasRect &rcNumSrc = sprites.numbers[0];
+  int offset = layout.offset;
+  long unsigned int id = 0;
+
+  track_field(dirty, id, game.get_field(),
+      game.get_index(), game.get_waiting_colour(),
+      layout.anchor_x, layout.anchor_y, offset, rcColourSrc.w);
+
+  // score digits (from the right), with the player indicator behind them.
+  for (int p = 0; p < 2; p++)
+  {
+    int right = p
+      ? SCREEN_WIDTH - offset
+      : offset + layout.number_places*rcNumSrc.w;
+    int rest = game.get_score_of_player(p);
+    bool current = game.get_current_player() == p;
+
+    for (int place = 0; place < layout.number_places; place++, rest /= 10)
+    {
+      int digit = rest > 0 ? rest % 10 : place ? -1 : 0;
+
+      dirty.track(id++, DirtyRect(right - (place + 1)*rcNumSrc.w, offset,
+            rcNumSrc.w, rcNumSrc.h), digit * 2 + current);
+    }
+  }
+
+  // waiting list, centred.
+  int waiting_width = (rcColourSrc.w + offset)*game.count_colours_waiting();
+  long waiting = game.count_colours_waiting();
+  for (long unsigned int i = 0; i < game.count_colours_waiting(); i++)
+  {
+    waiting = waiting * 16 + game.get_waiting_colour(i);
+  }
+  dirty.track(id++, DirtyRect((SCREEN_WIDTH - waiting_width) / 2, offset,
+        waiting_width, rcColourSrc.h), waiting);
+
+  for (long unsigned int i = 0; i < blobs_h.count_blobs(); i++)
+  {
+    dirty.track(id++, blobs_h.get_blob_area(i, layout.blobs_y),
+        blobs_h.get_blob_frame(i));
+  }
+}
+
+/* Track the changes, draw only the dirty areas and present them. */
+void render_game_frame(
+    Renderer *renderer,
+    DirtyRegions &dirty,
+    const GameSprites &sprites,
+    const GameLayout &layout,
+    Game &game,
+    BlobGuiHandler &blobs_h)
+{
+  track_game(dirty, sprites, layout, game, blobs_h);
+
+  for (const DirtyRect &area : dirty.get_rects())
+  {
+    renderer->set_clip(&area);
+    renderer->fill_rect(area, 0xffffff); // fill white.
+    display_game(renderer, sprites, layout, game, blobs_h);
+  }
+
+  renderer->set_clip(NULL);
+  renderer->present(dirty.get_rects());  // update the screen, only there.
+  dirty.clear();
+}
+
+#endif // _GUI_DRAW_H_
@@ -0,0 +1,157 @@
+#ifndef _GUI_RENDER_SDL1_H_
+#define _GUI_RENDER_SDL1_H_
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SDL.h"
+
+#include "render.h"
+
+/* SDL 1.2: blits into the screen surface, updates only the drawn areas.
+ * Included by gui_sdl.h. */
+class SurfaceRenderer : public Renderer
+{
+  private:
+    SDL_Surface *screen = NULL, *sprites = NULL, *icon = NULL;
+    std::vector<SDL_Rect> updated;
+
+  public:
+    ~SurfaceRenderer();
+
+    bool open(std::string title, std::string icon_path, int width, int height);
+    bool load_sprites(const uint32_t *pixels, int width, int height);
+    void draw_sprite(const AtlasRect &frame, int x, int y);
+    void fill_rect(const DirtyRect &area, uint32_t colour);
+    void set_clip(const DirtyRect *area);
+    void present(const std::vector<DirtyRect> &areas);
+    void close();
+};
+
+SurfaceRenderer::~SurfaceRenderer()
+{
+  this->close();
+}
+
+bool SurfaceRenderer::open(std::string title, std::string icon_path,
+    int width, int height)
+{
+  if (SDL_Init(SDL_INIT_VIDEO) < 0)
+  {
+    std::cerr << "Initialising SDL failed: " << SDL_GetError() << std::endl;
+    return false;
+  }
+
+  SDL_WM_SetCaption(title.c_str(), title.c_str());
+
+  /* The icon is set before the video mode. */
+  if ((icon = SDL_LoadBMP(icon_path.c_str())) != NULL)
+  {
+    set_colour_key(icon, 0xff, 0x0, 0xff);
+    SDL_WM_SetIcon(icon, NULL);
+  }
+  else
+  {
+    std::cerr << "Loading the icon failed." << std::endl;
+  }
+
+  this->screen = SDL_SetVideoMode(width, height, 0, 0);
+
+  if (!screen)
+  {
+    std::cerr << "Setting the video mode failed: " << SDL_GetError() << std::endl;
+    return false;
+  }
+
+  SDL_EnableKeyRepeat(70, 70); // set keyboard repeat.
+
+  return true;
+}
+
+bool SurfaceRenderer::load_sprites(const uint32_t *pixels, int width, int height)
+{
+  SDL_Surface *given = surface_of_pixels(pixels, width, height);
+
+  if (!given) return false;
+
+  if (sprites) SDL_FreeSurface(sprites);
+  this->sprites = SDL_DisplayFormat(given);  // copied, fast to blit.
+  SDL_FreeSurface(given);
+
+  if (!sprites) return false;
+
+  SDL_SetColorKey(sprites, SDL_SRCCOLORKEY | SDL_RLEACCEL,
+      SDL_MapRGB(sprites->format, 0xff, 0x0, 0xff));
+
+  return true;
+}
+
+void SurfaceRenderer::draw_sprite(const AtlasRect &frame, int x, int y)
+{
+  SDL_Rect src, dst;
+
+  src.x = frame.x; src.y = frame.y; src.w = frame.w; src.h = frame.h;
+  dst.x = x; dst.y = y;
+
+  SDL_BlitSurface(sprites, &src, screen, &dst);
+}
+
+void SurfaceRenderer::fill_rect(const DirtyRect &area, uint32_t colour)
+{
+  SDL_Rect rect;
+  rect.x = area.x; rect.y = area.y; rect.w = area.w; rect.h = area.h;
+
+  SDL_FillRect(screen, &rect, SDL_MapRGB(screen->format,
+        colour >> 16 & 0xff, colour >> 8 & 0xff, colour & 0xff));
+}
+
+void SurfaceRenderer::set_clip(const DirtyRect *area)
+{
+  if (!area)
+  {
+    SDL_SetClipRect(screen, NULL);
+    return;
+  }
+
+  SDL_Rect rect;
+  rect.x = area->x; rect.y = area->y; rect.w = area->w; rect.h = area->h;
+
+  SDL_SetClipRect(screen, &rect);
+}
+
+void SurfaceRenderer::present(const std::vector<DirtyRect> &areas)
+{
+  this->updated.clear();
+
+  for (const DirtyRect &area : areas)
+  {
+    SDL_Rect rect;
+    rect.x = area.x; rect.y = area.y; rect.w = area.w; rect.h = area.h;
+    this->updated.push_back(rect);
+  }
+
+  if (!updated.empty())  // update the screen, only there.
+  {
+    SDL_UpdateRects(screen, updated.size(), updated.data());
+  }
+}
+
+void SurfaceRenderer::close()
+{
+  if (sprites) SDL_FreeSurface(sprites);
+  if (icon) SDL_FreeSurface(icon);
+
+  this->sprites = NULL;
+  this->icon = NULL;
+  this->screen = NULL;  // freed by SDL_Quit().
+}
+
+/* Renderer of this SDL; software: ignored, SDL 1.2 blits in software. */
+std::unique_ptr<Renderer> create_renderer(bool = false)
+{
+  return std::unique_ptr<Renderer>(new SurfaceRenderer());
+}
+
+#endif // _GUI_RENDER_SDL1_H_
@@ -0,0 +1,182 @@
+#ifndef _GUI_RENDER_SDL2_H_
+#define _GUI_RENDER_SDL2_H_
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SDL.h"
+
+#include "render.h"
+
+/**
+ * SDL 2: the sprites are a texture, copies are batched by the renderer.
+ * Everything is drawn into a canvas texture, which keeps the last frame,
+ * so only the changed areas are drawn; presenting copies the canvas.
+ * Without a GPU (or if asked to), SDL's software renderer is used.
+ * Included by gui_sdl.h.
+ */
+class TextureRenderer : public Renderer
+{
+  private:
+    bool software;
+
+    SDL_Window *window = NULL;
+    SDL_Renderer *renderer = NULL;
+    SDL_Texture *sprites = NULL, *canvas = NULL;
+
+  public:
+    TextureRenderer(bool software = false);
+    ~TextureRenderer();
+
+    bool open(std::string title, std::string icon_path, int width, int height);
+    bool load_sprites(const uint32_t *pixels, int width, int height);
+    void draw_sprite(const AtlasRect &frame, int x, int y);
+    void fill_rect(const DirtyRect &area, uint32_t colour);
+    void set_clip(const DirtyRect *area);
+    void present(const std::vector<DirtyRect> &areas);
+    void close();
+};
+
+TextureRenderer::TextureRenderer(bool software) : software(software)
+{
+}
+
+TextureRenderer::~TextureRenderer()
+{
+  this->close();
+}
+
+bool TextureRenderer::open(std::string title, std::string icon_path,
+    int width, int height)
+{
+  if (SDL_Init(SDL_INIT_VIDEO) < 0)
+  {
+    std::cerr << "Initialising SDL failed: " << SDL_GetError() << std::endl;
+    return false;
+  }
+
+#ifdef SDL_HINT_RENDER_BATCHING
+  SDL_SetHint(SDL_HINT_RENDER_BATCHING, "1");
+#endif
+
+  this->window = SDL_CreateWindow(title.c_str(),
+      SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, 0);
+
+  if (!window)
+  {
+    std::cerr << "Creating the window failed: " << SDL_GetError() << std::endl;
+    return false;
+  }
+
+  SDL_Surface *icon = SDL_LoadBMP(icon_path.c_str());
+  if (icon)
+  {
+    set_colour_key(icon, 0xff, 0x0, 0xff);
+    SDL_SetWindowIcon(window, icon);
+    SDL_FreeSurface(icon);
+  }
+  else
+  {
+    std::cerr << "Loading the icon failed." << std::endl;
+  }
+
+  if (!software)
+  {
+    this->renderer = SDL_CreateRenderer(window, -1,
+        SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+  }
+  if (!renderer)  // no GPU.
+  {
+    this->renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+  }
+
+  this->canvas = !renderer ? NULL : SDL_CreateTexture(renderer,
+      SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+
+  if (!canvas)
+  {
+    std::cerr << "Creating the renderer failed: " << SDL_GetError() << std::endl;
+    return false;
+  }
+
+  SDL_SetRenderTarget(renderer, canvas);
+
+  return true;
+}
+
+bool TextureRenderer::load_sprites(const uint32_t *pixels, int width, int height)
+{
+  SDL_Surface *given = surface_of_pixels(pixels, width, height);
+
+  if (!given) return false;
+
+  set_colour_key(given, 0xff, 0x0, 0xff);
+
+  if (sprites) SDL_DestroyTexture(sprites);
+  this->sprites = SDL_CreateTextureFromSurface(renderer, given);
+  SDL_FreeSurface(given);
+
+  return sprites != NULL;
+}
+
+void TextureRenderer::draw_sprite(const AtlasRect &frame, int x, int y)
+{
+  SDL_Rect src = { frame.x, frame.y, frame.w, frame.h };
+  SDL_Rect dst = { x, y, frame.w, frame.h };
+
+  SDL_RenderCopy(renderer, sprites, &src, &dst);
+}
+
+void TextureRenderer::fill_rect(const DirtyRect &area, uint32_t colour)
+{
+  SDL_Rect rect = { area.x, area.y, area.w, area.h };
+
+  SDL_SetRenderDrawColor(renderer,
+      colour >> 16 & 0xff, colour >> 8 & 0xff, colour & 0xff, 0xff);
+  SDL_RenderFillRect(renderer, &rect);
+}
+
+void TextureRenderer::set_clip(const DirtyRect *area)
+{
+  if (!area)
+  {
+    SDL_RenderSetClipRect(renderer, NULL);
+    return;
+  }
+
+  SDL_Rect rect = { area->x, area->y, area->w, area->h };
+  SDL_RenderSetClipRect(renderer, &rect);
+}
+
+void TextureRenderer::present(const std::vector<DirtyRect> &areas)
+{
+  if (areas.empty()) return;  // nothing new.
+
+  SDL_SetRenderTarget(renderer, NULL);
+  SDL_RenderCopy(renderer, canvas, NULL, NULL);
+  SDL_RenderPresent(renderer);
+  SDL_SetRenderTarget(renderer, canvas);
+}
+
+void TextureRenderer::close()
+{
+  if (sprites) SDL_DestroyTexture(sprites);
+  if (canvas) SDL_DestroyTexture(canvas);
+  if (renderer) SDL_DestroyRenderer(renderer);
+  if (window) SDL_DestroyWindow(window);
+
+  this->sprites = NULL;
+  this->canvas = NULL;
+  this->renderer = NULL;
+  this->window = NULL;
+}
+
+/* Renderer of this SDL; software: without acceleration. */
+std::unique_ptr<Renderer> create_renderer(bool software = false)
+{
+  return std::unique_ptr<Renderer>(new TextureRenderer(software));
+}
+
+#endif // _GUI_RENDER_SDL2_H_
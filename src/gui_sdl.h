@@ -0,0 +1,49 @@
+#ifndef _GUI_SDL_H_
+#define _GUI_SDL_H_
+
+#include <memory>
+
+#include "SDL.h"
+
+#include "render.h"
+
+/*
+ * Differences of SDL 1.2 and SDL 2, the program is built with one of them
+ * (sdl-config or sdl2-config, see the Makefile).
+ */
+
+/* Make the colour transparent, when the surface is copied. */
+void set_colour_key(SDL_Surface *surface, int r, int g, int b)
+{
+#if SDL_MAJOR_VERSION >= 2
+  SDL_SetColorKey(surface, SDL_TRUE, SDL_MapRGB(surface->format, r, g, b));
+#else
+  SDL_SetColorKey(surface, SDL_SRCCOLORKEY, SDL_MapRGB(surface->format, r, g, b));
+#endif
+}
+
+/* True, if the window was covered and has to be drawn again. */
+bool is_expose_event(const SDL_Event &event)
+{
+#if SDL_MAJOR_VERSION >= 2
+  return event.type == SDL_WINDOWEVENT
+    && event.window.event == SDL_WINDOWEVENT_EXPOSED;
+#else
+  return event.type == SDL_VIDEOEXPOSE;
+#endif
+}
+
+/* Surface over the pixels (0xRRGGBB, no copy). */
+SDL_Surface *surface_of_pixels(const uint32_t *pixels, int width, int height)
+{
+  return SDL_CreateRGBSurfaceFrom((void *) pixels, width, height, 32,
+      width * 4, 0xff0000, 0x00ff00, 0x0000ff, 0);
+}
+
+#if SDL_MAJOR_VERSION >= 2
+#include "gui_render_sdl2.h"
+#else
+#include "gui_render_sdl1.h"
+#endif
+
+#endif // _GUI_SDL_H_
@@ -1,30 +1,61 @@
+#include <ctime>
 #include <iostream>
+#include <string>
 
 #include "gui.h"
 #include "test.h"
 
 bool pass_tests(bool verbose = true)
 {
-  bool passed_all = true;
+  bool passed_all = test_field_kernel(verbose);
+  passed_all &= test_ring_queue(verbose);
+  passed_all &= test_frame_pacer(verbose);
+  passed_all &= test_dirty_regions(verbose);
+  passed_all &= test_atlas_layout(verbose);
+  passed_all &= test_memory_renderer(verbose);
 
   for (int r = 4; r < 10; r++)
   {
     for (int c = 4; c < 10; c++)
     {
       passed_all &= test_field(r, c, 7, verbose);
+      passed_all &= test_field_backend<BitField>("BitField", r, c, 3, verbose);
+      passed_all &= test_field_backend<ColumnField>("ColumnField", r, c, 3, verbose);
+      passed_all &= test_field_backend<PackedField<3>>("PackedField", r, c, 3, verbose);
+      passed_all &= test_field_backend<PackedField<4>>("PackedField", r, c, 7, verbose);
+      passed_all &= test_game_cascade(r, c, verbose);
+      passed_all &= test_field_hash(r, c, verbose);
+      passed_all &= test_game_undo(r, c, verbose);
+      passed_all &= test_game_replay(r, c, verbose);
+      passed_all &= test_replay_seek(r, c, verbose);
+      passed_all &= test_game_session(r, c, verbose);
+      passed_all &= test_greedy_player(r, c, verbose);
     }
   }
 
+  passed_all &= test_expectimax_player(4, 4, verbose);
+  passed_all &= test_expectimax_player(4, 5, verbose);
+
+  passed_all &= test_field_backend<FixedField<5, 5>>("FixedField", 5, 5, 3, verbose);
+  passed_all &= test_field_backend<FixedField<4, 9>>("FixedField", 4, 9, 3, verbose);
+  passed_all &= test_field_backend<FixedField<9, 4>>("FixedField", 9, 4, 3, verbose);
+
   return passed_all;
 }
 
 int main(int argc, char *argv[])
 {
-  if (!pass_tests(argc > 1))  // tests, always, verbose, if not with window.
+  srand(time(0));
+
+  // --ai: window, player 1 is the AI; any other argument: no window.
+  bool versus_ai = argc > 1 && std::string(argv[1]) == "--ai";
+  bool window = argc < 2 || versus_ai;
+
+  if (!pass_tests(!window))  // tests, always, verbose, if not with window.
   {
     std::cerr << "Test(s) failed. (exit(1))" << std::endl;
     return 1;
   }
 
-  return argc < 2 ? start_window(5 , 5, 15 /*second per turn*/) : 0;
+  return window ? start_window(5 , 5, 15 /*second per turn*/, versus_ai) : 0;
 }
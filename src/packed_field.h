@@ -0,0 +1,136 @@
+#ifndef _PACKED_FIELD_H_
+#define _PACKED_FIELD_H_
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "field.h"
+#include "field_backend.h"
+
+/* Field backend, which packs every cell into Bits bits (3: up to 7 colours,
+ * 4: up to 15 colours), 64 / Bits cells per word, none split over two words.
+ * It behaves like Field, but a board needs 8 to 10 times less memory,
+ * e.g. for stress boards with millions of cells or for board dumps. */
+template <int Bits = 3>
+class PackedField : public FieldBackend<PackedField<Bits>>
+{
+  static_assert(Bits == 3 || Bits == 4, "PackedField packs 3 or 4 bits.");
+
+  friend class FieldBackend<PackedField<Bits>>;
+
+  private:
+    static constexpr int PER_WORD = 64 / Bits;  // cells per word.
+    static constexpr uint64_t MASK = (1 << Bits) - 1;
+
+    int rows, cols, size;
+    std::vector<uint64_t> words;  // cell i: word i / PER_WORD
+
+    std::vector<int> covered;  // search scratch.
+
+    static const char *name() { return "PackedField"; }
+
+    int *search_scratch();
+
+    // colours, which do not fit into Bits, are invalid.
+    static constexpr int max_colour() { return MAX_COLOUR; }
+
+    int get(int index);  // unchecked.
+    void put(int index, int colour);  // unchecked.
+
+    int cell(int row, int col);  // unchecked.
+    int put(int row, int col, int colour);  // unchecked, return old field
+
+  public:
+    static constexpr int MAX_COLOUR = (1 << Bits) - 1;
+
+    // number of rows and cols
+    PackedField(int rows = 5, int cols = 5);
+
+    void resize(int rows, int cols);  // reset the whole field dimensions.
+
+    int get_size();
+    int get_rows();
+    int get_cols();
+
+    /* The packed cells, e.g. to dump the whole board at once. */
+    const std::vector<uint64_t> &get_words();
+};
+
+template <int Bits>
+PackedField<Bits>::PackedField(int rows, int cols)
+{
+  this->resize(rows, cols);
+}
+
+template <int Bits>
+void PackedField<Bits>::resize(int rows, int cols)
+{
+  this->rows = rows;
+  this->cols = cols;
+  this->size = rows * cols;
+
+  this->words.assign((size + PER_WORD - 1) / PER_WORD, 0);  // all empty.
+  this->covered.assign(cols, -1);
+}
+
+template <int Bits>
+int PackedField<Bits>::get_size()
+{
+  return this->size;
+}
+
+template <int Bits>
+int PackedField<Bits>::get_rows()
+{
+  return this->rows;
+}
+
+template <int Bits>
+int PackedField<Bits>::get_cols()
+{
+  return this->cols;
+}
+
+template <int Bits>
+const std::vector<uint64_t> &PackedField<Bits>::get_words()
+{
+  return this->words;
+}
+
+template <int Bits>
+int PackedField<Bits>::get(int index)
+{
+  return (words[index / PER_WORD] >> (index % PER_WORD * Bits)) & MASK;
+}
+
+template <int Bits>
+void PackedField<Bits>::put(int index, int colour)
+{
+  uint64_t &word = words[index / PER_WORD];
+  int shift = index % PER_WORD * Bits;
+
+  word = (word & ~(MASK << shift)) | ((uint64_t) colour << shift);
+}
+
+template <int Bits>
+int *PackedField<Bits>::search_scratch()
+{
+  return this->covered.data();
+}
+
+template <int Bits>
+int PackedField<Bits>::cell(int row, int col)
+{
+  return this->get(row * cols + col);
+}
+
+template <int Bits>
+int PackedField<Bits>::put(int row, int col, int colour)
+{
+  int old = this->get(row * cols + col);
+  this->put(row * cols + col, colour);
+  return old;
+}
+
+#endif // _PACKED_FIELD_H_
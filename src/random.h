@@ -0,0 +1,83 @@
+#ifndef _RANDOM_H_
+#define _RANDOM_H_
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+/**
+ * Small and fast random engine (xoshiro256**), owned by whom draws from it.
+ * Unlike rand(), it is not shared between threads, and the same seed gives
+ * the same numbers on every machine, so a game can be replayed.
+ */
+class Random
+{
+  private:
+    uint64_t state[4];
+
+    static uint64_t rotl(uint64_t x, int k)
+    {
+      return (x << k) | (x >> (64 - k));
+    }
+
+  public:
+    Random(uint64_t seed = 0)
+    {
+      this->seed(seed);
+    }
+
+    /* Restart with that seed, spread by splitmix64 (never all zero). */
+    void seed(uint64_t seed)
+    {
+      for (int i = 0; i < 4; i++)
+      {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        state[i] = z ^ (z >> 31);
+      }
+    }
+
+    uint64_t next()
+    {
+      uint64_t result = rotl(state[1] * 5, 7) * 9;
+      uint64_t t = state[1] << 17;
+
+      state[2] ^= state[0];
+      state[3] ^= state[1];
+      state[1] ^= state[2];
+      state[0] ^= state[3];
+      state[2] ^= t;
+      state[3] = rotl(state[3], 45);
+
+      return result;
+    }
+
+    /* The four state words, to store the engine and to continue it. */
+    void get_state(uint64_t words[4]) const
+    {
+      for (int i = 0; i < 4; i++) words[i] = state[i];
+    }
+
+    void set_state(const uint64_t words[4])
+    {
+      for (int i = 0; i < 4; i++) state[i] = words[i];
+    }
+
+    /* Number in [0, n), n > 0. Multiply and shift, instead of modulo. */
+    int below(int n)
+    {
+      return (int) (((next() >> 32) * (uint64_t) n) >> 32);
+    }
+};
+
+/* Seed, which differs on every call, for runs, which need no replay. */
+uint64_t random_seed()
+{
+  static thread_local std::random_device device;
+
+  return ((uint64_t) device() << 32 ^ device())
+    ^ std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+#endif // _RANDOM_H_
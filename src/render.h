@@ -0,0 +1,47 @@
+#ifndef _RENDER_H_
+#define _RENDER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "atlas.h"
+#include "dirty_regions.h"
+
+#define SPRITE_KEY 0xff00ff  // transparent colour of the sprites (pink).
+
+/**
+ * Draws the window: sprites of the atlas, filled areas, and presents the
+ * drawn areas. The game's drawing only uses this; the backend follows the
+ * SDL, the program is built with (see gui_sdl.h).
+ * Colours are 0xRRGGBB.
+ */
+class Renderer
+{
+  public:
+    virtual ~Renderer() {}
+
+    /* Open the window (icon: picture, pink is transparent). */
+    virtual bool open(std::string title, std::string icon_path,
+        int width, int height) = 0;
+
+    /* Take the sprites (row by row, pixels in SPRITE_KEY are transparent),
+     * the renderer keeps its own copy. */
+    virtual bool load_sprites(const uint32_t *pixels, int width, int height) = 0;
+
+    /* Draw that frame of the sprites with its upper left corner at (x, y). */
+    virtual void draw_sprite(const AtlasRect &frame, int x, int y) = 0;
+
+    virtual void fill_rect(const DirtyRect &area, uint32_t colour) = 0;
+
+    /* Draw only into that area (NULL: everywhere). */
+    virtual void set_clip(const DirtyRect *area) = 0;
+
+    /* Show what was drawn into those areas (nothing, if none). */
+    virtual void present(const std::vector<DirtyRect> &areas) = 0;
+
+    /* Free the sprites and close the window. */
+    virtual void close() = 0;
+};
+
+#endif // _RENDER_H_
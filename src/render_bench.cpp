@@ -0,0 +1,231 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bmp.h"
+#include "dirty_regions.h"
+#include "game.h"
+#include "gui_atlas.h"
+#include "gui_blob_handler.h"
+#include "gui_draw.h"
+#include "render_memory.h"
+#include "session.h"
+
+// Headless rendering without SDL: compare the frames of fixed games with
+// the reference pictures, and measure the frames per second.
+
+const uint64_t SEED = 42;  // same games, same blobs, same frames.
+const int TURNS = 6;  // turns played before the reference frame.
+const int FRAMES = 300;  // frames measured per mode.
+const int BLOB_UPDATE_FRAMES = 30;  // the window's 500 ms, at 60 fps.
+
+const int SIZES[][2] = { {4, 4}, {5, 5}, {6, 6}, {7, 7} };
+
+/* A game of the size, with its blobs, rendered into memory. */
+class BenchGame
+{
+  public:
+    MemoryRenderer renderer;
+    GameLayout layout;
+    BlobGuiHandler blobs_h;
+    GameSession session;
+    DirtyRegions dirty;
+
+    long turn_index = 0;
+
+    BenchGame(int rows, int cols, const GameSprites &sprites)
+      : layout(rows, cols, sprites.colours[0]),
+      blobs_h(SCREEN_WIDTH/2, BLOB_SIZE, BLOB_COUNT),
+      session(rows, cols, 7, blobs_h.max_blobs(), COLOUR_WAITING_LIST, SEED),
+      dirty(SCREEN_WIDTH, SCREEN_HEIGHT)
+    {
+      blobs_h.set_texture(sprites.blobs, BLOB_FRAMES, BLOB_FRAME_SETS);
+      blobs_h.set_velocity(BLOB_SIZE / 3);
+
+      session.start();
+      set_colour_scores(session.get_game());
+    }
+
+    /* Advance one tick; choose and confirm the next index, when asked. */
+    void tick()
+    {
+      Game &game = session.get_game();
+      bool scorer;
+
+      if (session.get_phase() == SESSION_CHOOSING && !session.is_confirmed()
+          && !game.is_over())
+      {
+        session.set_index(turn_index++ * 7 % game.get_field()->get_bounds_max());
+        session.confirm();
+      }
+
+      session.tick();
+
+      while (session.pop_scorer(scorer)) blobs_h.new_blob_for_player(scorer);
+    }
+
+    /* Play until the turns are over and the game waits for a choice. */
+    void play_turns(int turns)
+    {
+      while (turn_index < turns || session.is_confirmed()
+          || session.get_phase() != SESSION_CHOOSING)
+      {
+        if (session.get_game().is_over()) break;
+        this->tick();
+      }
+    }
+};
+
+/* Compare the frame with the reference (written, if missing or update). */
+bool check_reference(MemoryRenderer &renderer, std::string path, bool update)
+{
+  std::vector<uint32_t> reference;
+  int w, h;
+
+  if (update || !std::ifstream(path))
+  {
+    if (!write_bmp(path, renderer.get_pixels().data(),
+          renderer.get_width(), renderer.get_height())) return false;
+
+    std::cout << "  reference written: " << path << std::endl;
+    return true;
+  }
+
+  if (!read_bmp(path, reference, w, h)) return false;
+
+  if (w != renderer.get_width() || h != renderer.get_height())
+  {
+    std::cerr << "  reference " << path << ": size " << w << "x" << h
+      << ", rendered " << renderer.get_width() << "x" << renderer.get_height()
+      << std::endl;
+    return false;
+  }
+
+  long different = 0;
+  for (long unsigned int i = 0; i < reference.size(); i++)
+  {
+    different += reference[i] != renderer.get_pixels()[i];
+  }
+
+  if (different)
+  {
+    std::string failed = path.substr(path.rfind('/') + 1);
+    write_bmp(failed, renderer.get_pixels().data(),
+        renderer.get_width(), renderer.get_height());
+
+    std::cerr << "  reference " << path << ": " << different
+      << " pixels differ, rendered: " << failed << std::endl;
+    return false;
+  }
+
+  std::cout << "  reference matches: " << path << std::endl;
+  return true;
+}
+
+/* Frames per second of rendering; full: every frame completely. */
+double measure_fps(BenchGame &bench, const GameSprites &sprites, bool full,
+    long &presented)
+{
+  long before = bench.renderer.count_presented();
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (int frame = 0; frame < FRAMES; frame++)
+  {
+    bench.tick();
+
+    // lively blobs, as in the window.
+    if (frame % BLOB_UPDATE_FRAMES == 0) bench.blobs_h.update_all_blobs(true);
+
+    if (full) bench.dirty.mark_all();
+
+    render_game_frame(&bench.renderer, bench.dirty, sprites, bench.layout,
+        bench.session.get_game(), bench.blobs_h);
+  }
+
+  double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  presented = (bench.renderer.count_presented() - before) / FRAMES;
+
+  return FRAMES / seconds;
+}
+
+void print_usage(char *name)
+{
+  std::cerr
+    << "Usage: " << name << " [res_dir] [update]" << std::endl
+    << "  res_dir: res, references in res_dir/reference" << std::endl
+    << "  update: write the references anew" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc > 1 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help"))
+  {
+    print_usage(argv[0]);
+    return 0;
+  }
+
+  std::string res_dir = argc > 1 ? argv[1] : "res";
+  bool update = argc > 2 && std::string(argv[2]) == "update";
+
+  SpriteAtlas atlas;
+  GameSprites sprites;
+
+  add_game_sprites(atlas, res_dir);
+
+  if (!atlas.build() || !find_game_sprites(atlas, sprites))
+  {
+    std::cerr << "Loading the sprites failed. Exit (1)" << std::endl;
+    return 1;
+  }
+
+  bool passed = true;
+
+  for (const int *size : SIZES)
+  {
+    int rows = size[0], cols = size[1];
+    std::string name = std::to_string(rows) + "x" + std::to_string(cols);
+
+    srand(SEED);  // the blobs.
+
+    BenchGame bench(rows, cols, sprites);
+    bench.renderer.open("", "", SCREEN_WIDTH, SCREEN_HEIGHT);
+    bench.renderer.load_sprites(atlas.get_pixels(),
+        atlas.get_width(), atlas.get_height());
+
+    std::cout << "Board " << name << ":" << std::endl;
+
+    /* Reference: the first frame after some turns. */
+    bench.play_turns(TURNS);
+    render_game_frame(&bench.renderer, bench.dirty, sprites, bench.layout,
+        bench.session.get_game(), bench.blobs_h);
+
+    passed &= check_reference(bench.renderer,
+        res_dir + "/reference/board_" + name + ".bmp", update);
+
+    long full_pixels, dirty_pixels;
+    double full_fps = measure_fps(bench, sprites, true, full_pixels);
+    double dirty_fps = measure_fps(bench, sprites, false, dirty_pixels);
+
+    std::cout
+      << "  full frames:  " << full_fps << " fps ("
+        << full_pixels << " pixels/frame)" << std::endl
+      << "  dirty frames: " << dirty_fps << " fps ("
+        << dirty_pixels << " pixels/frame)" << std::endl;
+
+    bench.renderer.close();
+  }
+
+  if (!passed)
+  {
+    std::cerr << "Rendered frames differ from the references. Exit (1)" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
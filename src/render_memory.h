@@ -0,0 +1,153 @@
+#ifndef _RENDER_MEMORY_H_
+#define _RENDER_MEMORY_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "render.h"
+
+/**
+ * Renders into pixels in memory, without a window and without SDL:
+ * for comparing frames with reference pictures, and for benchmarks.
+ * Presenting only counts the frames and the presented pixels.
+ */
+class MemoryRenderer : public Renderer
+{
+  private:
+    int width = 0, height = 0;
+    std::vector<uint32_t> pixels;  // 0xRRGGBB, row by row.
+
+    int sprites_width = 0;
+    std::vector<uint32_t> sprites;
+
+    DirtyRect clip;
+
+    long frames = 0;
+    long presented = 0;  // pixels.
+
+  public:
+    bool open(std::string title, std::string icon_path, int width, int height);
+    bool load_sprites(const uint32_t *pixels, int width, int height);
+    void draw_sprite(const AtlasRect &frame, int x, int y);
+    void fill_rect(const DirtyRect &area, uint32_t colour);
+    void set_clip(const DirtyRect *area);
+    void present(const std::vector<DirtyRect> &areas);
+    void close();
+
+    /* The drawn pixels. */
+    const std::vector<uint32_t> &get_pixels();
+    int get_width();
+    int get_height();
+
+    /* Presented frames (with any area) and their pixels, so far. */
+    long count_frames();
+    long count_presented();
+};
+
+bool MemoryRenderer::open(std::string, std::string, int width, int height)
+{
+  this->width = width;
+  this->height = height;
+  this->pixels.assign(width * height, 0);
+  this->set_clip(NULL);
+
+  return width > 0 && height > 0;
+}
+
+bool MemoryRenderer::load_sprites(const uint32_t *pixels, int width, int height)
+{
+  this->sprites_width = width;
+  this->sprites.assign(pixels, pixels + width * height);
+
+  return true;
+}
+
+void MemoryRenderer::draw_sprite(const AtlasRect &frame, int x, int y)
+{
+  /* Part of the frame inside of the clip area. */
+  int left = clip.x > x ? clip.x - x : 0;
+  int top = clip.y > y ? clip.y - y : 0;
+  int right = clip.x + clip.w < x + frame.w ? clip.x + clip.w - x : frame.w;
+  int bottom = clip.y + clip.h < y + frame.h ? clip.y + clip.h - y : frame.h;
+
+  for (int fy = top; fy < bottom; fy++)
+  {
+    const uint32_t *from = &sprites[(frame.y + fy) * sprites_width + frame.x];
+    uint32_t *to = &pixels[(y + fy) * width + x];
+
+    for (int fx = left; fx < right; fx++)
+    {
+      if (from[fx] != SPRITE_KEY) to[fx] = from[fx];
+    }
+  }
+}
+
+void MemoryRenderer::fill_rect(const DirtyRect &area, uint32_t colour)
+{
+  int left = area.x > clip.x ? area.x : clip.x;
+  int top = area.y > clip.y ? area.y : clip.y;
+  int right = area.x + area.w < clip.x + clip.w ? area.x + area.w : clip.x + clip.w;
+  int bottom = area.y + area.h < clip.y + clip.h ? area.y + area.h : clip.y + clip.h;
+
+  for (int y = top; y < bottom; y++)
+  {
+    for (int x = left; x < right; x++) this->pixels[y * width + x] = colour;
+  }
+}
+
+void MemoryRenderer::set_clip(const DirtyRect *area)
+{
+  this->clip = DirtyRect(0, 0, width, height);
+
+  if (!area) return;
+
+  /* Inside of the screen. */
+  int right = area->x + area->w < width ? area->x + area->w : width;
+  int bottom = area->y + area->h < height ? area->y + area->h : height;
+
+  clip.x = area->x > 0 ? area->x : 0;
+  clip.y = area->y > 0 ? area->y : 0;
+  clip.w = right > clip.x ? right - clip.x : 0;
+  clip.h = bottom > clip.y ? bottom - clip.y : 0;
+}
+
+void MemoryRenderer::present(const std::vector<DirtyRect> &areas)
+{
+  if (areas.empty()) return;
+
+  this->frames ++;
+  for (const DirtyRect &area : areas) this->presented += area.area();
+}
+
+void MemoryRenderer::close()
+{
+  this->sprites.clear();
+}
+
+const std::vector<uint32_t> &MemoryRenderer::get_pixels()
+{
+  return this->pixels;
+}
+
+int MemoryRenderer::get_width()
+{
+  return this->width;
+}
+
+int MemoryRenderer::get_height()
+{
+  return this->height;
+}
+
+long MemoryRenderer::count_frames()
+{
+  return this->frames;
+}
+
+long MemoryRenderer::count_presented()
+{
+  return this->presented;
+}
+
+#endif // _RENDER_MEMORY_H_
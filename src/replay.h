@@ -0,0 +1,281 @@
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Replay stream, append only:
+ *   header: "SABR", version, rows, cols, colours, blobs, waiting (varints),
+ *           seed (8 bytes, little endian).
+ *   turn:   index (varint), then
+ *           one byte colour << 4 | new colour, if both are in [1, 15]
+ *           and one colour was queued (the usual turn), else
+ *           0, colour, count of new colours, new colours (varints).
+ * The engine state of every turn follows from the seed and the colours
+ * drawn so far, the game draws nothing else after start().
+ */
+
+const char REPLAY_MAGIC[4] = {'S', 'A', 'B', 'R'};
+const int REPLAY_VERSION = 1;
+
+/* Game setup of a replay, to start the same game again. */
+class ReplayHeader
+{
+  public:
+    int rows = 0, cols = 0, colours = 0, blobs = 0, waiting = 0;
+    uint64_t seed = 0;
+};
+
+/* One recorded turn. */
+class ReplayTurn
+{
+  public:
+    int index = 0;  // insertion index.
+    int colour = 0;  // inserted colour.
+    std::vector<int> queued;  // colours appended to the waiting list.
+};
+
+/**
+ * Packs turns into a buffer, a background thread writes full buffers to
+ * the stream, while the next one is filled (double buffering).
+ * The game thread only waits, if the stream is slower than the game.
+ */
+class ReplayWriter
+{
+  private:
+    std::ostream &out;
+    long unsigned int buffer_size;
+
+    std::vector<char> filling, writing;  // swapped, when filling is full.
+    bool has_writing = false;  // writing is handed to the thread.
+    bool stopping = false;
+
+    std::mutex mutex;
+    std::condition_variable wake, written;
+    std::thread writer;
+
+    void put_varint(uint64_t value);
+    void hand_over();  // pass filling to the thread, wait for a free buffer.
+    void work();
+
+  public:
+    ReplayWriter(std::ostream &out, long unsigned int buffer_size = 1 << 16);
+
+    /* Write everything left and stop the thread. */
+    ~ReplayWriter();
+
+    void write_header(const ReplayHeader &header);
+    void write_turn(int index, int colour, const int *queued, int count);
+
+    /* Write everything buffered so far, and flush the stream. */
+    void flush();
+};
+
+ReplayWriter::ReplayWriter(std::ostream &out, long unsigned int buffer_size)
+  : out(out), buffer_size(buffer_size < 64 ? 64 : buffer_size)
+{
+  this->filling.reserve(this->buffer_size + 64);
+  this->writing.reserve(this->buffer_size + 64);
+  this->writer = std::thread(&ReplayWriter::work, this);
+}
+
+ReplayWriter::~ReplayWriter()
+{
+  this->flush();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->stopping = true;
+  }
+  wake.notify_all();
+
+  writer.join();
+}
+
+void ReplayWriter::put_varint(uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    filling.push_back((char) ((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  filling.push_back((char) value);
+}
+
+void ReplayWriter::write_header(const ReplayHeader &header)
+{
+  filling.insert(filling.end(), REPLAY_MAGIC, REPLAY_MAGIC + 4);
+  this->put_varint(REPLAY_VERSION);
+  this->put_varint(header.rows);
+  this->put_varint(header.cols);
+  this->put_varint(header.colours);
+  this->put_varint(header.blobs);
+  this->put_varint(header.waiting);
+
+  for (int i = 0; i < 8; i++)
+  {
+    filling.push_back((char) (header.seed >> (8 * i)));
+  }
+}
+
+void ReplayWriter::write_turn(int index, int colour, const int *queued, int count)
+{
+  this->put_varint(index);
+
+  if (count == 1 && colour >= 1 && colour <= 15 && queued[0] >= 1 && queued[0] <= 15)
+  {
+    filling.push_back((char) (colour << 4 | queued[0]));
+  }
+  else
+  {
+    filling.push_back(0);
+    this->put_varint(colour);
+    this->put_varint(count);
+    for (int i = 0; i < count; i++) this->put_varint(queued[i]);
+  }
+
+  if (filling.size() >= buffer_size) this->hand_over();
+}
+
+void ReplayWriter::hand_over()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+
+  written.wait(lock, [this] { return !has_writing; });
+
+  std::swap(filling, writing);
+  this->has_writing = true;
+
+  wake.notify_all();
+}
+
+void ReplayWriter::flush()
+{
+  if (!filling.empty()) this->hand_over();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  written.wait(lock, [this] { return !has_writing; });
+
+  out.flush();
+}
+
+void ReplayWriter::work()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+
+  while (true)
+  {
+    wake.wait(lock, [this] { return stopping || has_writing; });
+    if (!has_writing) return;  // stopping, all written.
+
+    lock.unlock();
+    out.write(writing.data(), writing.size());
+    writing.clear();
+    lock.lock();
+
+    this->has_writing = false;
+    written.notify_all();
+  }
+}
+
+/* Reads a replay stream, written by ReplayWriter. */
+class ReplayReader
+{
+  private:
+    std::istream &in;
+
+    bool get_varint(uint64_t &value);
+
+  public:
+    ReplayReader(std::istream &in);
+
+    /* Read the header, return false, if it is none. */
+    bool read_header(ReplayHeader &header);
+
+    /* Read the next turn, return false at the end of the stream. */
+    bool read_turn(ReplayTurn &turn);
+};
+
+ReplayReader::ReplayReader(std::istream &in) : in(in)
+{
+}
+
+bool ReplayReader::get_varint(uint64_t &value)
+{
+  int c;
+  value = 0;
+
+  for (int shift = 0; shift < 64 && (c = in.get()) != EOF; shift += 7)
+  {
+    value |= (uint64_t) (c & 0x7f) << shift;
+    if (!(c & 0x80)) return true;
+  }
+
+  return false;
+}
+
+bool ReplayReader::read_header(ReplayHeader &header)
+{
+  char magic[4];
+  uint64_t version, rows, cols, colours, blobs, waiting;
+
+  if (!in.read(magic, 4) || !std::equal(magic, magic + 4, REPLAY_MAGIC))
+    return false;
+
+  if (!get_varint(version) || version != REPLAY_VERSION
+      || !get_varint(rows) || !get_varint(cols) || !get_varint(colours)
+      || !get_varint(blobs) || !get_varint(waiting))
+    return false;
+
+  header.rows = rows;
+  header.cols = cols;
+  header.colours = colours;
+  header.blobs = blobs;
+  header.waiting = waiting;
+  header.seed = 0;
+
+  for (int i = 0, c; i < 8; i++)
+  {
+    if ((c = in.get()) == EOF) return false;
+    header.seed |= (uint64_t) (c & 0xff) << (8 * i);
+  }
+
+  return true;
+}
+
+bool ReplayReader::read_turn(ReplayTurn &turn)
+{
+  uint64_t index, colour, count, queued;
+  int packed;
+
+  if (!get_varint(index) || (packed = in.get()) == EOF) return false;
+
+  turn.index = index;
+  turn.queued.clear();
+
+  if (packed)
+  {
+    turn.colour = packed >> 4 & 0xf;
+    turn.queued.push_back(packed & 0xf);
+    return true;
+  }
+
+  if (!get_varint(colour) || !get_varint(count)) return false;
+
+  turn.colour = colour;
+  for (uint64_t i = 0; i < count; i++)
+  {
+    if (!get_varint(queued)) return false;
+    turn.queued.push_back(queued);
+  }
+
+  return true;
+}
+
+#endif // _REPLAY_H_
@@ -0,0 +1,321 @@
+#ifndef _REPLAY_SEEK_H_
+#define _REPLAY_SEEK_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "replay.h"
+
+/**
+ * Jump to any turn of a replay: a keyframe file keeps the whole game state
+ * every interval turns, from there at most interval - 1 turns are played.
+ * The keyframes are fixed size records (little endian), the file is
+ * memory-mapped, only the touched keyframes are read from the disk.
+ * Turns are played with the recorded colours, also where the engine would
+ * draw others.
+ *
+ * Keyframe: turn, scores, blobs, player (int32 each), engine state (four
+ *           uint64), waiting colours and cells (one byte each), padded to
+ *           8 bytes.
+ */
+class ReplaySeeker
+{
+  private:
+    ReplayHeader header;
+    std::vector<ReplayTurn> turns;
+    int interval = 1;
+
+    Game game;  // at the turn of the last seek.
+    GameState state;  // scratch.
+
+    const unsigned char *keyframes = NULL;  // mapped file.
+    long unsigned int mapped_size = 0;
+    long unsigned int keyframe_size = 0;
+
+    int applied = 0;  // turns played by the last seek.
+    int differing = 0;  // turns, whose colours the engine did not draw.
+
+    bool play_turn(int turn, CascadeLog &log);
+    bool write_keyframe(FILE *file, int turn);
+    void read_keyframe(int keyframe);
+    void close();
+
+  public:
+    ReplaySeeker();
+
+    /* Unmap the keyframes. */
+    ~ReplaySeeker();
+
+    /* Read the replay and play it with the colour scores (per colour),
+     * write a keyframe every interval turns into keyframe_path and map it.
+     * Return false, if the replay or the file can not be used. */
+    bool open(std::istream &replay, std::vector<int> colour_scores,
+        std::string keyframe_path, int interval = 64);
+
+    ReplayHeader &get_header();
+
+    /* Number of recorded turns. */
+    int count_turns();
+
+    /* Get the game before that turn (0: started, count_turns(): ended).
+     * Invalid turns are clamped. */
+    Game &seek(int turn);
+
+    /* Turns, the last seek() played from its keyframe. */
+    int count_applied();
+
+    /* Turns of open(), whose recorded colours differ from the ones the
+     * engine draws from the seed (0 for a replay of a normal game). */
+    int count_differing();
+};
+
+ReplaySeeker::ReplaySeeker()
+{
+}
+
+ReplaySeeker::~ReplaySeeker()
+{
+  this->close();
+}
+
+void ReplaySeeker::close()
+{
+  if (keyframes) munmap((void *) keyframes, mapped_size);
+
+  this->keyframes = NULL;
+  this->mapped_size = 0;
+}
+
+ReplayHeader &ReplaySeeker::get_header()
+{
+  return this->header;
+}
+
+int ReplaySeeker::count_turns()
+{
+  return this->turns.size();
+}
+
+int ReplaySeeker::count_applied()
+{
+  return this->applied;
+}
+
+int ReplaySeeker::count_differing()
+{
+  return this->differing;
+}
+
+static void put_le32(unsigned char *&p, uint32_t value)
+{
+  for (int i = 0; i < 4; i++) *p++ = (unsigned char) (value >> (8 * i));
+}
+
+static void put_le64(unsigned char *&p, uint64_t value)
+{
+  for (int i = 0; i < 8; i++) *p++ = (unsigned char) (value >> (8 * i));
+}
+
+static uint32_t get_le32(const unsigned char *&p)
+{
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) value |= (uint32_t) *p++ << (8 * i);
+  return value;
+}
+
+static uint64_t get_le64(const unsigned char *&p)
+{
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) value |= (uint64_t) *p++ << (8 * i);
+  return value;
+}
+
+/* Play the recorded turn: its colour is inserted, its colours are queued.
+ * Return false, if the engine had other colours for it. */
+bool ReplaySeeker::play_turn(int turn, CascadeLog &log)
+{
+  const ReplayTurn &recorded = turns[turn];
+
+  game.get_state(state);
+  bool drawn = !state.waiting.empty() && state.waiting[0] == recorded.colour;
+
+  if (!drawn)
+  {
+    if (state.waiting.empty()) state.waiting.push_back(0);
+    state.waiting[0] = recorded.colour;
+    game.set_state(state);
+  }
+
+  game.set_index(recorded.index);
+  game.play_turn(log);
+
+  game.get_state(state);
+
+  long unsigned int queued = recorded.queued.size();
+  long unsigned int from = state.waiting.size() - queued;
+  bool same = queued <= state.waiting.size()
+    && std::equal(recorded.queued.begin(), recorded.queued.end(),
+        state.waiting.begin() + from);
+
+  if (!same)
+  {
+    if (queued > state.waiting.size()) from = 0, state.waiting.resize(queued);
+    std::copy(recorded.queued.begin(), recorded.queued.end(),
+        state.waiting.begin() + from);
+    game.set_state(state);
+  }
+
+  return drawn && same;
+}
+
+bool ReplaySeeker::open(std::istream &replay, std::vector<int> colour_scores,
+    std::string keyframe_path, int interval)
+{
+  ReplayReader reader(replay);
+  ReplayTurn turn;
+
+  this->close();
+  this->turns.clear();
+  this->interval = interval < 1 ? 1 : interval;
+  this->differing = 0;
+
+  if (!reader.read_header(header)) return false;
+
+  while (reader.read_turn(turn)) this->turns.push_back(turn);
+
+  this->game = Game(header.rows, header.cols, header.colours, header.blobs,
+      header.waiting, header.seed);
+  for (long unsigned int colour = 0; colour < colour_scores.size(); colour++)
+  {
+    this->game.set_colour_score(colour, colour_scores[colour]);
+  }
+  this->game.start();
+
+  this->keyframe_size = (4 * 6 + 8 * 4
+      + header.waiting + header.rows * header.cols + 7) / 8 * 8;
+
+  FILE *file = fopen(keyframe_path.c_str(), "w+b");
+  if (!file) return false;
+
+  CascadeLog log;
+  bool written = true;
+
+  for (int t = 0; t <= count_turns() && written; t++)
+  {
+    if (t % this->interval == 0) written = this->write_keyframe(file, t);
+    if (t == count_turns()) break;
+
+    this->differing += !this->play_turn(t, log);
+  }
+
+  if (!written || fflush(file) != 0)
+  {
+    std::cerr << "ReplaySeeker::open(" << keyframe_path << ") "
+      << "- writing the keyframes failed." << std::endl;
+    fclose(file);
+    return false;
+  }
+
+  this->mapped_size = (count_turns() / this->interval + 1) * keyframe_size;
+  void *mapped = mmap(NULL, mapped_size, PROT_READ, MAP_SHARED, fileno(file), 0);
+
+  fclose(file);  // the mapping stays.
+
+  if (mapped == MAP_FAILED)
+  {
+    this->mapped_size = 0;
+    return false;
+  }
+
+  this->keyframes = (const unsigned char *) mapped;
+
+  return true;
+}
+
+bool ReplaySeeker::write_keyframe(FILE *file, int turn)
+{
+  std::vector<unsigned char> record(keyframe_size, 0);
+  unsigned char *p = record.data();
+  uint64_t words[4];
+
+  game.get_state(state);
+
+  put_le32(p, turn);
+  put_le32(p, state.score[0]);
+  put_le32(p, state.score[1]);
+  put_le32(p, state.blobs[0]);
+  put_le32(p, state.blobs[1]);
+  put_le32(p, state.player1);
+
+  state.random.get_state(words);
+  for (int i = 0; i < 4; i++) put_le64(p, words[i]);
+
+  for (int i = 0; i < header.waiting; i++)
+  {
+    *p++ = (long unsigned int) i < state.waiting.size() ? state.waiting[i] : 0;
+  }
+  for (int colour : state.cells) *p++ = colour;
+
+  return fwrite(record.data(), 1, keyframe_size, file) == keyframe_size;
+}
+
+void ReplaySeeker::read_keyframe(int keyframe)
+{
+  const unsigned char *p = keyframes + keyframe * keyframe_size;
+  uint64_t words[4];
+
+  get_le32(p);  // turn.
+  state.score[0] = (int32_t) get_le32(p);
+  state.score[1] = (int32_t) get_le32(p);
+  state.blobs[0] = (int32_t) get_le32(p);
+  state.blobs[1] = (int32_t) get_le32(p);
+  state.player1 = get_le32(p);
+
+  for (int i = 0; i < 4; i++) words[i] = get_le64(p);
+  state.random.set_state(words);
+
+  state.waiting.clear();
+  for (int i = 0; i < header.waiting; i++, p++)
+  {
+    if (*p) state.waiting.push_back(*p);
+  }
+
+  state.cells.resize(header.rows * header.cols);
+  for (int &colour : state.cells) colour = *p++;
+
+  game.set_state(state);
+}
+
+/* Start from the keyframe at or before the turn, play the rest. */
+Game &ReplaySeeker::seek(int turn)
+{
+  this->applied = 0;
+
+  if (!keyframes) return this->game;
+
+  turn = turn < 0 ? 0 : turn > count_turns() ? count_turns() : turn;
+
+  this->read_keyframe(turn / interval);
+
+  CascadeLog log;
+
+  for (int t = turn / interval * interval; t < turn; t++, applied++)
+  {
+    this->play_turn(t, log);
+  }
+
+  return this->game;
+}
+
+#endif // _REPLAY_SEEK_H_
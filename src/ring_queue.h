@@ -0,0 +1,113 @@
+#ifndef _RING_QUEUE_H_
+#define _RING_QUEUE_H_
+
+#include <vector>
+
+/**
+ * Queue in a ring of slots, allocated once with the capacity.
+ * Popping the first (or last) item and pushing at either end only moves an
+ * index, nothing is shifted and nothing is allocated, unless the capacity
+ * is exceeded; then the ring doubles.
+ */
+template <class T>
+class RingQueue
+{
+  private:
+    std::vector<T> slots;  // power of two.
+    long unsigned int head = 0;  // slot of the first item.
+    long unsigned int count = 0;
+
+    void grow();
+
+  public:
+    RingQueue(long unsigned int capacity = 8);
+
+    long unsigned int size() const { return count; }
+    bool empty() const { return count == 0; }
+    long unsigned int capacity() const { return slots.size(); }
+
+    /* i-th item from the first one, unchecked. */
+    T &operator[](long unsigned int i)
+    {
+      return slots[(head + i) & (slots.size() - 1)];
+    }
+
+    const T &operator[](long unsigned int i) const
+    {
+      return slots[(head + i) & (slots.size() - 1)];
+    }
+
+    T &front() { return (*this)[0]; }
+    T &back() { return (*this)[count - 1]; }
+
+    void push_back(const T &item);
+    void push_front(const T &item);
+    void pop_front();
+    void pop_back();
+
+    void clear();
+};
+
+template <class T>
+RingQueue<T>::RingQueue(long unsigned int capacity)
+{
+  long unsigned int slots = 1;
+  while (slots < capacity) slots <<= 1;
+
+  this->slots.resize(slots);
+}
+
+/* Double the slots, the items start at slot 0 again. */
+template <class T>
+void RingQueue<T>::grow()
+{
+  std::vector<T> bigger(slots.size() * 2);
+
+  for (long unsigned int i = 0; i < count; i++) bigger[i] = (*this)[i];
+
+  this->slots.swap(bigger);
+  this->head = 0;
+}
+
+template <class T>
+void RingQueue<T>::push_back(const T &item)
+{
+  if (count == slots.size()) this->grow();
+
+  this->count ++;
+  this->back() = item;
+}
+
+template <class T>
+void RingQueue<T>::push_front(const T &item)
+{
+  if (count == slots.size()) this->grow();
+
+  this->head = (head + slots.size() - 1) & (slots.size() - 1);
+  this->count ++;
+  this->front() = item;
+}
+
+template <class T>
+void RingQueue<T>::pop_front()
+{
+  if (!count) return;
+
+  this->head = (head + 1) & (slots.size() - 1);
+  this->count --;
+}
+
+template <class T>
+void RingQueue<T>::pop_back()
+{
+  if (count) this->count --;
+}
+
+template <class T>
+void RingQueue<T>::clear()
+{
+  this->head = 0;
+  this->count = 0;
+}
+
+#endif // _RING_QUEUE_H_
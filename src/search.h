@@ -0,0 +1,259 @@
+#ifndef _SEARCH_H_
+#define _SEARCH_H_
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "game.h"
+#include "transposition.h"
+#include "worker_pool.h"
+
+/**
+ * Headless player, which searches several turns ahead (expectimax).
+ * The value of a position is the score difference for the player to move:
+ * the score of a move minus the value of the next position.
+ * The first plies insert the known waiting colours, the later ones are
+ * chance nodes, which average over all colours (they are equally likely).
+ *
+ * The search deepens ply by ply until the deadline, only fully searched
+ * depths count (anytime). Root moves are shared by the workers, which
+ * share the transposition table; entries only answer the same depth, so
+ * the result does not depend on the thread timing.
+ * The table is kept over turns, so one player should keep to one game.
+ */
+class ExpectimaxPlayer
+{
+  private:
+    class Worker
+    {
+      public:
+        Field field;
+        FieldUndo undo;
+        std::vector<FieldPattern> removed;  // patterns of all made moves.
+        long nodes = 0;
+    };
+
+    WorkerPool pool;
+    TranspositionTable table;
+    int max_depth;
+
+    // current search, set by choose_index().
+    Game *game = NULL;
+    std::vector<int> known;  // waiting colours.
+    std::chrono::steady_clock::time_point deadline;
+    std::atomic<bool> timeout;
+
+    int best_index, best_value, depth;
+    long nodes;
+
+    int make_move(Worker &w, int index, int colour);  // return its score.
+    uint64_t key_of(Worker &w, int ply);
+    int value_of(Worker &w, int ply, int depth);
+    int value_of_colour(Worker &w, int ply, int depth, int colour);
+
+  public:
+    /* Start the workers (0: one per hardware thread), search at most
+     * max_depth turns, with 2^table_size_log2 transposition slots. */
+    ExpectimaxPlayer(int threads = 0, int max_depth = 8, int table_size_log2 = 20);
+
+    int count_threads();
+
+    /* Search the best insertion index for the current waiting colour,
+     * until time_budget (ms) is over. The game is not changed.
+     * The first turn is always searched fully, even after the deadline. */
+    int choose_index(Game &game, long time_budget);
+
+    /* Value (score difference) of the last chosen index. */
+    int get_best_value();
+
+    /* Turns, the last choose_index() searched fully. */
+    int get_depth();
+
+    /* Positions, the last choose_index() visited. */
+    long count_nodes();
+
+    /* Forget all positions, e.g. for a game with other colour scores. */
+    void clear();
+};
+
+ExpectimaxPlayer::ExpectimaxPlayer(int threads, int max_depth, int table_size_log2)
+  : pool(threads), table(table_size_log2)
+{
+  this->max_depth = max_depth < 1 ? 1 : max_depth;
+  this->timeout = false;
+}
+
+int ExpectimaxPlayer::count_threads()
+{
+  return this->pool.count_threads();
+}
+
+int ExpectimaxPlayer::get_best_value()
+{
+  return this->best_value;
+}
+
+int ExpectimaxPlayer::get_depth()
+{
+  return this->depth;
+}
+
+long ExpectimaxPlayer::count_nodes()
+{
+  return this->nodes;
+}
+
+void ExpectimaxPlayer::clear()
+{
+  this->table.clear();
+}
+
+int ExpectimaxPlayer::choose_index(Game &game, long time_budget)
+{
+  this->game = &game;
+  this->known.clear();
+  for (long unsigned int i = 0; i < game.count_colours_waiting(); i++)
+  {
+    this->known.push_back(game.get_waiting_colour(i));
+  }
+
+  this->deadline = std::chrono::steady_clock::now()
+    + std::chrono::milliseconds(time_budget);
+  this->timeout = false;
+  this->best_index = 0;
+  this->best_value = 0;
+  this->depth = 0;
+  this->nodes = 0;
+
+  if (known.empty()) return 0;  // not started.
+
+  int bounds_max = game.get_field()->get_bounds_max();
+  std::vector<int> values(bounds_max);
+  std::vector<Worker> workers(pool.count_threads());
+
+  for (Worker &w : workers) w.field = *game.get_field();
+
+  for (int d = 1; d <= max_depth && !timeout; d++)
+  {
+    std::atomic<int> next_index(0);
+
+    pool.run([&] (int worker)
+    {
+      Worker &w = workers[worker];
+
+      for (int index = next_index++; index < bounds_max; index = next_index++)
+      {
+        int score = this->make_move(w, index, known[0]);
+        values[index] = score - this->value_of(w, 1, d - 1);
+        w.field.unmake_move(w.undo);
+      }
+    });
+
+    if (timeout) break;  // this depth is not complete.
+
+    this->depth = d;
+    this->best_index = 0;
+    for (int index = 1; index < bounds_max; index++)
+    {
+      if (values[index] > values[best_index]) this->best_index = index;
+    }
+    this->best_value = values[best_index];
+  }
+
+  for (Worker &w : workers) this->nodes += w.nodes;
+  this->game = NULL;
+
+  return this->best_index;
+}
+
+/* Make the move in the worker's field, score its removed patterns. */
+int ExpectimaxPlayer::make_move(Worker &w, int index, int colour)
+{
+  int first = w.removed.size(), score = 0;
+
+  w.field.make_move(index, colour, w.undo, w.removed);
+
+  for (long unsigned int i = first; i < w.removed.size(); i++)
+  {
+    score += game->get_pattern_score(w.removed[i]);
+  }
+  w.removed.erase(w.removed.begin() + first, w.removed.end());
+
+  w.nodes ++;
+  return score;
+}
+
+/* Field hash and the waiting colours, which are still known at that ply. */
+uint64_t ExpectimaxPlayer::key_of(Worker &w, int ply)
+{
+  uint64_t key = w.field.get_hash();
+
+  for (long unsigned int i = ply; i < known.size(); i++)
+  {
+    key ^= zobrist_key(-2 - (i - ply), known[i]);
+  }
+
+  return key;
+}
+
+/**
+ * Value of the position for the player to move, depth turns ahead.
+ * After the deadline, it returns 0 and the whole depth is dropped.
+ */
+int ExpectimaxPlayer::value_of(Worker &w, int ply, int depth)
+{
+  if (depth < 1 || timeout) return 0;
+
+  if ((w.nodes & 0xff) == 0 && std::chrono::steady_clock::now() > deadline)
+  {
+    this->timeout = true;
+    return 0;
+  }
+
+  uint64_t key = this->key_of(w, ply);
+  TranspositionEntry entry;
+
+  if (table.probe(key, entry) && entry.depth == depth) return entry.score;
+
+  int value = 0;
+
+  if ((long unsigned int) ply < known.size())  // known colour.
+  {
+    value = this->value_of_colour(w, ply, depth, known[ply]);
+  }
+  else  // chance: every colour is equally likely.
+  {
+    int colours = game->count_colours();
+
+    for (int colour = 1; colour <= colours; colour++)
+    {
+      value += this->value_of_colour(w, ply, depth, colour);
+    }
+    value /= colours;
+  }
+
+  if (!timeout) table.store(key, TranspositionEntry(value, depth));
+
+  return value;
+}
+
+/* Best move for that colour: its score minus the value of the next turn. */
+int ExpectimaxPlayer::value_of_colour(Worker &w, int ply, int depth, int colour)
+{
+  int bounds_max = w.field.get_bounds_max();
+  int best = 0;
+
+  for (int index = 0; index < bounds_max; index++)
+  {
+    int value = this->make_move(w, index, colour);
+    value -= this->value_of(w, ply + 1, depth - 1);
+    w.field.unmake_move(w.undo);
+
+    if (index == 0 || value > best) best = value;
+  }
+
+  return best;
+}
+
+#endif // _SEARCH_H_
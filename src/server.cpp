@@ -0,0 +1,55 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "server.h"
+#include "test_server.h"
+
+// Game server without SDL: many games behind one Unix socket.
+
+GameServer *running_server = NULL;
+
+void stop_server(int)
+{
+  if (running_server) running_server->stop();
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc > 1 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help"))
+  {
+    std::cerr
+      << "Usage: " << argv[0] << " [socket] [threads] [max_sessions]" << std::endl
+      << "       " << argv[0] << " --test" << std::endl
+      << "  socket: /tmp/slideablob.sock, threads: 0 (all cores)," << std::endl
+      << "  max_sessions: " << SERVER_MAX_SESSIONS << std::endl;
+    return 0;
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--test")
+  {
+    return test_game_server(true) ? 0 : 1;
+  }
+
+  std::string path = argc > 1 ? argv[1] : "/tmp/slideablob.sock";
+  int threads = argc > 2 ? atoi(argv[2]) : 0;
+  long max_sessions = argc > 3 ? atol(argv[3]) : SERVER_MAX_SESSIONS;
+
+  GameServer server(threads, max_sessions);
+
+  if (!server.listen(path)) return 1;
+
+  running_server = &server;
+  signal(SIGINT, stop_server);
+  signal(SIGTERM, stop_server);
+  signal(SIGPIPE, SIG_IGN);  // closed clients are seen by write().
+
+  std::cout << "Serving on " << path << std::endl;
+  server.run();
+
+  std::cout << "Stopped, " << server.count_sessions() << " sessions left." << std::endl;
+  unlink(path.c_str());
+
+  return 0;
+}
@@ -0,0 +1,446 @@
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "worker_pool.h"
+
+/*
+ * Request, 9 bytes (little endian): op (u8), session (u32), argument (i32).
+ *   SERVER_START:     argument: rows | cols << 8 | colours << 16
+ *                     | waiting << 24, 0 for defaults (5, 5, 7, 3).
+ *                     Reply: new session (u32); an error, if the
+ *                     server runs its maximum of sessions.
+ *   SERVER_SET_INDEX: argument: insertion index. Reply: set index (i32).
+ *   SERVER_INSERT:    play the turn at the set index, with its cascade.
+ *                     Reply: score of the turn (i32).
+ *                     Both are errors, once the game is over.
+ *   SERVER_POLL:      Reply: rows, cols, player, over (u8), index (u16),
+ *                     scores (2 i32), blobs (2 u8), waiting count (u8),
+ *                     waiting colours and cells (u8 each).
+ *   SERVER_END:       forget the session. Reply: nothing.
+ * Reply: status (u8, SERVER_OK or SERVER_ERROR), payload length (u16),
+ *        payload.
+ */
+
+#define SERVER_START 1
+#define SERVER_SET_INDEX 2
+#define SERVER_INSERT 3
+#define SERVER_POLL 4
+#define SERVER_END 5
+
+#define SERVER_OK 0
+#define SERVER_ERROR 1
+
+const int SERVER_REQUEST_SIZE = 9;
+const long SERVER_MAX_SESSIONS = 100000;  // default; more starts fail.
+
+/**
+ * Many independent games in one process, served over a Unix socket.
+ * Every worker runs its own epoll loop over the connections it accepted;
+ * a session is not bound to a connection, the games are kept in shards
+ * with a lock each, so requests of different sessions rarely wait.
+ */
+class GameServer
+{
+  private:
+    class Shard
+    {
+      public:
+        std::mutex mutex;
+        std::unordered_map<uint32_t, std::unique_ptr<Game>> games;
+    };
+
+    class Connection
+    {
+      public:
+        std::vector<unsigned char> in, out;
+    };
+
+    static const int SHARDS = 64;
+
+    Shard shards[SHARDS];
+    std::atomic<uint32_t> next_session;
+    std::atomic<long> sessions;  // running.
+    long max_sessions;
+    std::atomic<bool> stopping;
+
+    WorkerPool pool;
+    int listener = -1;
+
+    Shard &shard_of(uint32_t session);
+
+    void event_loop(int worker);
+    bool read_connection(int fd, Connection &c);  // false: closed.
+    bool write_connection(int fd, Connection &c);  // false: closed.
+
+  public:
+    /* Start the workers (0: one per hardware thread); serve at most
+     * max_sessions games at once. */
+    GameServer(int threads = 0, long max_sessions = SERVER_MAX_SESSIONS);
+
+    /* Stop listening; the socket file is left to the caller. */
+    ~GameServer();
+
+    /* Listen on that socket path (replaced, if it exists). */
+    bool listen(std::string path);
+
+    /* Serve until stop(), on all workers. */
+    void run();
+
+    /* Let run() return, from any thread. */
+    void stop();
+
+    /* Number of running games. */
+    long unsigned int count_sessions();
+
+    /* Handle one request, append its reply. */
+    void handle_request(const unsigned char *request,
+        std::vector<unsigned char> &reply);
+};
+
+GameServer::GameServer(int threads, long max_sessions) : pool(threads)
+{
+  this->next_session = 1;
+  this->sessions = 0;
+  // fewer than session ids (2^32 - 1, without 0), one is always free.
+  this->max_sessions = max_sessions < UINT32_MAX ? max_sessions : UINT32_MAX - 1;
+  this->stopping = false;
+}
+
+GameServer::~GameServer()
+{
+  if (listener >= 0) close(listener);
+}
+
+GameServer::Shard &GameServer::shard_of(uint32_t session)
+{
+  return shards[session % SHARDS];
+}
+
+long unsigned int GameServer::count_sessions()
+{
+  long unsigned int count = 0;
+
+  for (Shard &shard : shards)
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    count += shard.games.size();
+  }
+
+  return count;
+}
+
+static void put_u8(std::vector<unsigned char> &out, int value)
+{
+  out.push_back((unsigned char) value);
+}
+
+static void put_u16(std::vector<unsigned char> &out, int value)
+{
+  out.push_back((unsigned char) value);
+  out.push_back((unsigned char) (value >> 8));
+}
+
+static void put_u32(std::vector<unsigned char> &out, uint32_t value)
+{
+  for (int i = 0; i < 4; i++) out.push_back((unsigned char) (value >> (8 * i)));
+}
+
+void GameServer::handle_request(const unsigned char *request,
+    std::vector<unsigned char> &reply)
+{
+  int op = request[0];
+  uint32_t session = 0, argument = 0;
+
+  for (int i = 0; i < 4; i++)
+  {
+    session |= (uint32_t) request[1 + i] << (8 * i);
+    argument |= (uint32_t) request[5 + i] << (8 * i);
+  }
+
+  long unsigned int start = reply.size();
+  put_u8(reply, SERVER_OK);
+  put_u16(reply, 0);  // length, set below.
+
+  if (op == SERVER_START)
+  {
+    int rows = argument & 0xff, cols = argument >> 8 & 0xff;
+    int colours = argument >> 16 & 0xff, waiting = argument >> 24 & 0xff;
+    int score[8] = { 0, 10, 20, 30, 40, 70, 100, 150 };
+
+    if (!argument) rows = cols = 5, colours = 7, waiting = 3;
+
+    if (rows < 1 || cols < 1 || colours < 1 || colours > 7 || waiting < 1)
+    {
+      reply[start] = SERVER_ERROR;
+      return;
+    }
+
+    if (sessions++ >= max_sessions)  // full, keep the shards bounded.
+    {
+      sessions--;
+      reply[start] = SERVER_ERROR;
+      return;
+    }
+
+    std::unique_ptr<Game> game(new Game(rows, cols, colours, 10, waiting));
+    for (int i = 0; i <= colours; i++) game->set_colour_score(i, score[i]);
+    game->start();
+
+    /* The ids wrap around after 2^32 sessions: skip 0 (start) and ids,
+     * which are still running; fewer than 2^32 run, one is free. */
+    while (game)
+    {
+      session = next_session++;
+      if (!session) continue;
+
+      Shard &shard = shard_of(session);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+
+      if (shard.games.count(session)) continue;
+      shard.games[session] = std::move(game);
+    }
+
+    put_u32(reply, session);
+  }
+  else
+  {
+    Shard &shard = shard_of(session);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto found = shard.games.find(session);
+    if (found == shard.games.end())
+    {
+      reply[start] = SERVER_ERROR;
+      return;
+    }
+
+    Game &game = *found->second;
+    CascadeLog log;
+
+    /* A finished game is only polled and ended. */
+    if (game.is_over() && (op == SERVER_SET_INDEX || op == SERVER_INSERT))
+    {
+      reply[start] = SERVER_ERROR;
+      return;
+    }
+
+    switch (op)
+    {
+      case SERVER_SET_INDEX:
+        game.set_index((int32_t) argument);
+        put_u32(reply, game.get_index());
+        break;
+
+      case SERVER_INSERT:
+        put_u32(reply, game.play_turn(log));
+        break;
+
+      case SERVER_POLL:
+      {
+        Field *field = game.get_field();
+
+        put_u8(reply, field->get_rows());
+        put_u8(reply, field->get_cols());
+        put_u8(reply, game.get_current_player());
+        put_u8(reply, game.is_over());
+        put_u16(reply, game.get_index());
+        put_u32(reply, game.get_score_of_player(0));
+        put_u32(reply, game.get_score_of_player(1));
+        put_u8(reply, game.get_blobs_of_player(0));
+        put_u8(reply, game.get_blobs_of_player(1));
+        put_u8(reply, game.count_colours_waiting());
+        for (long unsigned int i = 0; i < game.count_colours_waiting(); i++)
+        {
+          put_u8(reply, game.get_waiting_colour(i));
+        }
+        for (int i = 0; i < field->get_size(); i++)
+        {
+          put_u8(reply, field->colour_at(i));
+        }
+        break;
+      }
+
+      case SERVER_END:
+        shard.games.erase(found);
+        sessions--;
+        break;
+
+      default:
+        reply[start] = SERVER_ERROR;
+        return;
+    }
+  }
+
+  int length = reply.size() - start - 3;
+  reply[start + 1] = (unsigned char) length;
+  reply[start + 2] = (unsigned char) (length >> 8);
+}
+
+bool GameServer::listen(std::string path)
+{
+  struct sockaddr_un address;
+
+  if (path.size() >= sizeof(address.sun_path)) return false;
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path.c_str());
+
+  unlink(path.c_str());
+
+  this->listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if (listener < 0) return false;
+
+  if (bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0
+      || ::listen(listener, 128) < 0)
+  {
+    std::cerr << "GameServer::listen(" << path << ") "
+      << "- " << strerror(errno) << std::endl;
+    close(listener);
+    this->listener = -1;
+    return false;
+  }
+
+  return true;
+}
+
+void GameServer::run()
+{
+  this->stopping = false;
+
+  pool.run([this] (int worker) { this->event_loop(worker); });
+}
+
+void GameServer::stop()
+{
+  this->stopping = true;
+}
+
+/**
+ * Accept on the shared listener (each connection goes to one worker),
+ * then read whole requests, answer them, write what the socket takes.
+ * The loop wakes at least every 100 ms, to see stop().
+ */
+void GameServer::event_loop(int)
+{
+  int epoll = epoll_create1(0);
+  std::unordered_map<int, Connection> connections;
+  struct epoll_event event, events[64];
+
+  event.events = EPOLLIN | EPOLLEXCLUSIVE;
+  event.data.fd = listener;
+  epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+
+  while (!stopping)
+  {
+    int ready = epoll_wait(epoll, events, 64, 100);
+
+    for (int e = 0; e < ready; e++)
+    {
+      int fd = events[e].data.fd;
+
+      if (fd == listener)
+      {
+        int client;
+        while ((client = accept4(listener, NULL, NULL, SOCK_NONBLOCK)) >= 0)
+        {
+          event.events = EPOLLIN;
+          event.data.fd = client;
+          epoll_ctl(epoll, EPOLL_CTL_ADD, client, &event);
+          connections[client];
+        }
+        continue;
+      }
+
+      Connection &c = connections[fd];
+      bool open = true;
+
+      if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+      {
+        open = this->read_connection(fd, c);
+      }
+      if (open) open = this->write_connection(fd, c);
+
+      if (!open)
+      {
+        this->write_connection(fd, c);  // replies to the last requests.
+        epoll_ctl(epoll, EPOLL_CTL_DEL, fd, NULL);
+        close(fd);
+        connections.erase(fd);
+        continue;
+      }
+
+      // wait for writing, only while replies are left.
+      event.events = c.out.empty() ? EPOLLIN : EPOLLIN | EPOLLOUT;
+      event.data.fd = fd;
+      epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &event);
+    }
+  }
+
+  for (auto &connection : connections) close(connection.first);
+  close(epoll);
+}
+
+bool GameServer::read_connection(int fd, Connection &c)
+{
+  unsigned char buffer[4096];
+  ssize_t got;
+
+  while ((got = read(fd, buffer, sizeof(buffer))) > 0
+      || (got < 0 && errno == EINTR))
+  {
+    if (got > 0) c.in.insert(c.in.end(), buffer, buffer + got);
+  }
+
+  bool closed = got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+
+  long unsigned int done = 0;
+  for (; done + SERVER_REQUEST_SIZE <= c.in.size(); done += SERVER_REQUEST_SIZE)
+  {
+    this->handle_request(c.in.data() + done, c.out);
+  }
+  c.in.erase(c.in.begin(), c.in.begin() + done);
+
+  return !closed;
+}
+
+bool GameServer::write_connection(int fd, Connection &c)
+{
+  long unsigned int done = 0;
+  ssize_t sent;
+
+  while (done < c.out.size())
+  {
+    sent = write(fd, c.out.data() + done, c.out.size() - done);
+
+    if (sent > 0) done += sent;
+    else if (sent < 0 && errno == EINTR) continue;  // interrupted, again.
+    else break;
+  }
+
+  if (done < c.out.size() && errno != EAGAIN && errno != EWOULDBLOCK)
+    return false;
+
+  c.out.erase(c.out.begin(), c.out.begin() + done);
+  return true;
+}
+
+#endif // _SERVER_H_
@@ -0,0 +1,187 @@
+#ifndef _SESSION_H_
+#define _SESSION_H_
+
+#include <vector>
+
+#include "game.h"
+#include "ring_queue.h"
+
+#define TICKS_PER_SECOND 60  // logical steps per second.
+
+#define SESSION_CHOOSING 0  // the player moves the index, until confirmed.
+#define SESSION_REMOVING 1  // patterns are removed one by one.
+
+/**
+ * Turn state machine of a running game, advanced by fixed ticks, not by
+ * frames. A renderer only reads the game and the progress of the current
+ * step, to interpolate between two ticks, while the session runs at the
+ * same speed on every machine (or as fast as possible, headless).
+ */
+class GameSession
+{
+  private:
+    Game game;
+
+    int phase = SESSION_CHOOSING;
+    bool confirmed = false;
+    long ticks = 0;
+    int phase_ticks = 0;  // ticks since the last step of this phase.
+    int remove_ticks;  // ticks shown per pattern, before it is removed.
+
+    RingQueue<int> scorers;  // players (0 or 1), who removed a pattern.
+
+  public:
+    /* Same as Game(...), remove_ticks: ticks to show each pattern. */
+    GameSession(int rows = 5, int cols = 5, int colours = 5, int blobs = 10,
+        int waiting = 3, uint64_t seed = random_seed(), int remove_ticks = 15);
+
+    /* Get the game, to set it up and to read it. ATTENTION: Changes apply. */
+    Game &get_game();
+
+    /* Start the game, choosing the first insertion. */
+    void start();
+
+    /* Move the insertion index or confirm it, only while choosing. */
+    void inc_index();
+    void dec_index();
+    void set_index(int index);
+    void confirm();
+
+    /* Advance one logical step. */
+    void tick();
+
+    int get_phase();
+    bool is_confirmed();  // confirmed, inserted with the next tick.
+    long get_ticks();
+
+    /* Part of the current pattern's time, which is over, [0, 1]. */
+    double get_progress();
+
+    /* Get the next player, who removed a pattern since the last call.
+     * Return false, if there is none. */
+    bool pop_scorer(bool &player);
+};
+
+GameSession::GameSession(int rows, int cols, int colours, int blobs,
+    int waiting, uint64_t seed, int remove_ticks)
+  : game(rows, cols, colours, blobs, waiting, seed)
+{
+  this->remove_ticks = remove_ticks < 1 ? 1 : remove_ticks;
+}
+
+Game &GameSession::get_game()
+{
+  return this->game;
+}
+
+void GameSession::start()
+{
+  this->game.start();
+
+  this->phase = SESSION_CHOOSING;
+  this->confirmed = false;
+  this->ticks = 0;
+  this->phase_ticks = 0;
+  this->scorers.clear();
+}
+
+void GameSession::inc_index()
+{
+  if (phase == SESSION_CHOOSING && !confirmed) game.inc_index();
+}
+
+void GameSession::dec_index()
+{
+  if (phase == SESSION_CHOOSING && !confirmed) game.dec_index();
+}
+
+void GameSession::set_index(int index)
+{
+  if (phase == SESSION_CHOOSING && !confirmed) game.set_index(index);
+}
+
+void GameSession::confirm()
+{
+  if (phase == SESSION_CHOOSING) this->confirmed = true;
+}
+
+/**
+ * Choosing: a confirmed index is inserted, its patterns are searched.
+ * Removing: every remove_ticks, the first pattern is removed and scored;
+ * if none is left, search again (combo), else the next player's turn.
+ */
+void GameSession::tick()
+{
+  this->ticks ++;
+  this->phase_ticks ++;
+
+  if (phase == SESSION_CHOOSING)
+  {
+    if (!confirmed) return;
+
+    game.insert_colour();
+    game.update_pattern_waiting_list();
+
+    this->phase = SESSION_REMOVING;
+    this->phase_ticks = 0;
+    return;
+  }
+
+  if (game.has_waiting_patterns())
+  {
+    if (phase_ticks < remove_ticks) return;  // still shown.
+
+    game.add_score_to_current_player(game.remove_first_pattern());
+    this->scorers.push_back(game.get_current_player());
+    this->phase_ticks = 0;
+  }
+
+  if (game.has_waiting_patterns()) return;
+
+  /* Check, if new patterns were built. */
+  game.update_pattern_waiting_list();
+
+  /* New turn: next player, next colour, etc. */
+  if (!game.has_waiting_patterns())
+  {
+    game.next_turn();
+    game.new_colour();
+
+    this->phase = SESSION_CHOOSING;
+    this->confirmed = false;
+    this->phase_ticks = 0;
+  }
+}
+
+int GameSession::get_phase()
+{
+  return this->phase;
+}
+
+bool GameSession::is_confirmed()
+{
+  return this->confirmed;
+}
+
+long GameSession::get_ticks()
+{
+  return this->ticks;
+}
+
+double GameSession::get_progress()
+{
+  if (phase != SESSION_REMOVING) return 0;
+
+  return phase_ticks >= remove_ticks ? 1 : (double) phase_ticks / remove_ticks;
+}
+
+bool GameSession::pop_scorer(bool &player)
+{
+  if (scorers.empty()) return false;
+
+  player = scorers.front();
+  scorers.pop_front();
+  return true;
+}
+
+#endif // _SESSION_H_
@@ -0,0 +1,202 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ai.h"
+#include "field.h"
+#include "game.h"
+#include "worker_pool.h"
+
+// Batch self-play without SDL: play N games on all cores, print statistics.
+
+const int MAX_DEPTH = 8;  // cascade depth histogram, deeper ones are added up.
+const int SCORE_BUCKET = 100;  // score histogram bucket size.
+
+/* Statistics of played games, per worker, summed afterwards. */
+class SimulationStats
+{
+  public:
+    long games = 0;
+    long turns = 0;
+    long unfinished = 0;  // stopped at max turns.
+    long wins[2] = {0, 0};  // per seat.
+    long draws = 0;
+
+    long patterns = 0;
+    long depths[MAX_DEPTH + 1] = {0};  // turns per cascade depth.
+    long max_depth = 0;
+
+    long score_sum = 0;
+    long score_max = 0;
+    std::vector<long> scores;  // final scores per bucket.
+
+    void add_score(int score)
+    {
+      long unsigned int bucket = score / SCORE_BUCKET;
+
+      if (scores.size() <= bucket) scores.resize(bucket + 1, 0);
+      scores[bucket] ++;
+
+      score_sum += score;
+      if (score > score_max) score_max = score;
+    }
+
+    void add(const SimulationStats &other)
+    {
+      games += other.games;
+      turns += other.turns;
+      unfinished += other.unfinished;
+      wins[0] += other.wins[0];
+      wins[1] += other.wins[1];
+      draws += other.draws;
+      patterns += other.patterns;
+      for (int d = 0; d <= MAX_DEPTH; d++) depths[d] += other.depths[d];
+      if (other.max_depth > max_depth) max_depth = other.max_depth;
+
+      score_sum += other.score_sum;
+      if (other.score_max > score_max) score_max = other.score_max;
+      if (scores.size() < other.scores.size()) scores.resize(other.scores.size(), 0);
+      for (long unsigned int b = 0; b < other.scores.size(); b++) scores[b] += other.scores[b];
+    }
+};
+
+/* Play one game to its end (or max_turns), seat true: greedy, else random.
+ * The game only draws from its own seeded engine, it can be replayed; the
+ * random seats draw from their own engine, seeded apart from the game. */
+void play_game(SimulationStats &stats, int rows, int cols, int max_turns,
+    bool greedy[2], uint64_t seed)
+{
+  int score[8] = { 0, 10, 20, 30, 40, 70, 100, 150 };
+
+  Game game(rows, cols, 7, 10, 3, seed);
+  Random players(~seed);
+  CascadeLog log;
+  FieldUndo undo;
+  std::vector<FieldPattern> removed;
+
+  for (int i = 0; i < 8; i++) game.set_colour_score(i, score[i]);
+
+  game.start();
+
+  int turn;
+  for (turn = 0; turn < max_turns && !game.is_over(); turn++)
+  {
+    bool seat = game.get_current_player();
+
+    game.set_index(greedy[seat]
+        ? greedy_index(game, *game.get_field(), undo, removed)
+        : players.below(game.get_field()->get_bounds_max()));
+
+    game.play_turn(log);
+
+    int depth = log.steps.empty() ? -1 : log.combo_depth();
+    if (depth >= 0) stats.depths[depth < MAX_DEPTH ? depth : MAX_DEPTH] ++;
+    if (depth > stats.max_depth) stats.max_depth = depth;
+    stats.patterns += log.patterns.size();
+  }
+
+  stats.games ++;
+  stats.turns += turn;
+  stats.unfinished += !game.is_over();
+
+  int score0 = game.get_score_of_player(0), score1 = game.get_score_of_player(1);
+
+  if (!game.is_over() && score0 == score1) stats.draws ++;
+  else stats.wins[game.get_current_winner()] ++;
+
+  stats.add_score(score0);
+  stats.add_score(score1);
+}
+
+void print_usage(char *name)
+{
+  std::cerr
+    << "Usage: " << name << " [games] [threads] [rows] [cols] [max_turns]"
+      << " [seat0] [seat1] [seed]" << std::endl
+    << "  games: 1000, threads: 0 (all cores), rows, cols: 5, max_turns: 1000"
+      << std::endl
+    << "  seats: greedy (default) or random, seed: random" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc > 1 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help"))
+  {
+    print_usage(argv[0]);
+    return 0;
+  }
+
+  long games = argc > 1 ? atol(argv[1]) : 1000;
+  int threads = argc > 2 ? atoi(argv[2]) : 0;
+  int rows = argc > 3 ? atoi(argv[3]) : 5;
+  int cols = argc > 4 ? atoi(argv[4]) : 5;
+  int max_turns = argc > 5 ? atoi(argv[5]) : 1000;
+  bool greedy[2] = {
+    argc > 6 ? std::string(argv[6]) != "random" : true,
+    argc > 7 ? std::string(argv[7]) != "random" : true };
+  uint64_t seed = argc > 8 ? strtoull(argv[8], NULL, 10) : random_seed();
+
+  if (games < 1 || rows < 1 || cols < 1 || max_turns < 1)
+  {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  WorkerPool pool(threads);
+  std::vector<SimulationStats> worker_stats(pool.count_threads());
+  std::atomic<long> next_game(0);
+
+  auto start = std::chrono::steady_clock::now();
+
+  // games are handed out one by one, a worker done early takes the next.
+  pool.run([&] (int worker)
+  {
+    for (long game = next_game++; game < games; game = next_game++)
+    {
+      play_game(worker_stats[worker], rows, cols, max_turns, greedy, seed + game);
+    }
+  });
+
+  double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  SimulationStats stats;
+  for (SimulationStats &s : worker_stats) stats.add(s);
+
+  std::cout
+    << "Games: " << stats.games
+      << " (" << rows << "x" << cols << ", " << pool.count_threads()
+      << " threads, seats: " << (greedy[0] ? "greedy" : "random")
+      << " vs " << (greedy[1] ? "greedy" : "random")
+      << ", seed " << seed << ")" << std::endl
+    << "Games/s: " << stats.games / seconds
+      << " (" << seconds << " s)" << std::endl
+    << "Turns/game: " << (double) stats.turns / stats.games
+      << " (unfinished: " << stats.unfinished << ")" << std::endl
+    << "Patterns/turn: " << (double) stats.patterns / stats.turns << std::endl
+    << "Wins: seat 0: " << (double) stats.wins[0] / stats.games
+      << ", seat 1: " << (double) stats.wins[1] / stats.games
+      << ", draws: " << (double) stats.draws / stats.games << std::endl;
+
+  std::cout << "Cascade depth (turns with patterns), max " << stats.max_depth << ":";
+  for (int d = 0; d <= MAX_DEPTH; d++)
+  {
+    std::cout << " " << d << (d == MAX_DEPTH ? "+" : "") << ":" << stats.depths[d];
+  }
+  std::cout << std::endl;
+
+  std::cout
+    << "Score: avg " << (double) stats.score_sum / (2 * stats.games)
+      << ", max " << stats.score_max << std::endl;
+  for (long unsigned int b = 0; b < stats.scores.size(); b++)
+  {
+    if (!stats.scores[b]) continue;
+    std::cout << "  [" << b * SCORE_BUCKET << ", " << (b + 1) * SCORE_BUCKET
+      << "): " << stats.scores[b] << std::endl;
+  }
+
+  return 0;
+}
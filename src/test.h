@@ -1,11 +1,57 @@
 #ifndef _TESTS_H_
 #define _TESTS_H_
 
+#include<cstdlib>
 #include<iostream>
+#include<sstream>
 #include<string>
 #include<vector>
 
+#include<unistd.h>
+
+#include "ai.h"
+#include "atlas.h"
+#include "bmp.h"
 #include "field.h"
+#include "bit_field.h"
+#include "dirty_regions.h"
+#include "column_field.h"
+#include "fixed_field.h"
+#include "frame_pacer.h"
+#include "packed_field.h"
+#include "replay.h"
+#include "replay_seek.h"
+#include "ring_queue.h"
+#include "game.h"
+#include "gui_draw.h"
+#include "render_memory.h"
+#include "search.h"
+#include "session.h"
+#include "transposition.h"
+
+/* Path of a new, empty file in the temporary directory ($TMPDIR or /tmp),
+ * unique to this call. The caller removes it. */
+std::string temp_path(std::string name)
+{
+  const char *dir = getenv("TMPDIR");
+  std::string path = std::string(dir && *dir ? dir : "/tmp")
+    + "/" + name + "_XXXXXX";
+
+  std::vector<char> unique(path.begin(), path.end());
+  unique.push_back('\0');
+
+  int fd = mkstemp(unique.data());
+  if (fd < 0)
+  {
+    std::cerr << "temp_path(" << name << ") - no file created." << std::endl;
+  }
+  else
+  {
+    close(fd);
+  }
+
+  return unique.data();
+}
 
 std::string field_to_string(Field *g)
 {
@@ -467,4 +513,1124 @@ bool test_field(int rows, int cols, int field_variety = 7, bool verbose = true)
   return passed;
 }
 
+/* Compare patterns of two searches, same content in the same order. */
+bool same_patterns(std::vector<FieldPattern> *a, std::vector<FieldPattern> *b)
+{
+  if (a->size() != b->size()) return false;
+
+  for (long unsigned int i = 0; i < a->size(); i++)
+  {
+    if ((*a)[i].position != (*b)[i].position
+        || (*a)[i].type != (*b)[i].type
+        || (*a)[i].colour != (*b)[i].colour) return false;
+  }
+  return true;
+}
+
+/* Play the same random moves on a Field and on another field backend.
+ * Both must agree on every cell and on every found pattern. */
+template <class Backend>
+bool test_field_backend(
+    std::string name, int rows, int cols, int field_variety = 3,
+    bool verbose = true, int moves = 50)
+{
+  int passed_tests = 0, summed_tests = 0;
+  bool passed;
+  std::vector<int> custom_fields;
+  std::vector<FieldPattern> *expected, *found;
+
+  Field field(rows, cols);
+  Backend backend(rows, cols);
+
+  if (verbose) std::cout
+    << "## " << name << "(" << rows << "," << cols << ") "
+      << "plays like Field, " << moves << " moves." << std::endl;
+
+  for (int i = 0; i < rows * cols; i++)
+  {
+    custom_fields.push_back(1 + rand() % field_variety);
+  }
+  field.start(custom_fields);
+  backend.start(custom_fields);
+
+  for (int move = 0; move < moves; move++)
+  {
+    int index = rand() % field.get_bounds_max();
+    int colour = 1 + rand() % field_variety;
+
+    field.insert(index, colour);
+    backend.insert(index, colour);
+
+    // resolve all cascades.
+    bool cascade = true;
+    while (cascade)
+    {
+      passed = true;
+      for (int i = 0; i < field.get_size(); i++)
+      {
+        passed &= field.colour_at(i) == backend.colour_at(i);
+      }
+
+      expected = field.search_patterns();
+      found = backend.search_patterns();
+      passed &= same_patterns(expected, found);
+      cascade = passed && expected->size();
+
+      summed_tests += 1;
+      passed_tests += passed;
+
+      if (verbose && !passed) std::cout
+        << "[" << (summed_tests) << "] Failed after insert("
+          << index << ", " << colour << ")" << std::endl
+          << field_to_string(&field) << std::endl;
+
+      field.remove_patterns(expected);
+      backend.remove_patterns(found);
+    }
+
+    if (!passed) break;
+  }
+
+  passed = passed_tests == summed_tests;
+
+  if (verbose) std::cout
+    << "[Result] " << name << " rows: " << rows << ", cols: " << cols
+    << " -- Passed/Summed: "
+    << passed_tests << "/" << summed_tests
+    << " -- " << (passed ? "PASSED" : "FAILED") << "!"
+    << std::endl << "-------"
+    << std::endl << std::endl;
+
+  return passed;
+}
+
+/* Removing waiting patterns one by one (like the window does) ends in the
+ * same field and scores as resolving the whole cascade at once. */
+bool test_game_cascade(int rows, int cols, bool verbose = true, int turns = 30)
+{
+  int passed_tests = 0, summed_tests = 0;
+  bool passed;
+  int seed = rand();
+
+  Game stepped(rows, cols, 4, 10, 3, seed), resolved(rows, cols, 4, 10, 3, seed);
+  CascadeLog log;
+
+  for (int colour = 0; colour <= 4; colour++)
+  {
+    stepped.set_colour_score(colour, 10 * colour);
+    resolved.set_colour_score(colour, 10 * colour);
+  }
+
+  stepped.start();
+  resolved.start();
+
+  if (verbose) std::cout
+    << "## Game(" << rows << "," << cols << ") "
+      << "resolves cascades like step by step removal." << std::endl;
+
+  for (int turn = 0; turn < turns; turn++)
+  {
+    int index = rand() % stepped.get_field()->get_bounds_max();
+
+    stepped.set_index(index);
+    stepped.insert_colour();
+    stepped.update_pattern_waiting_list();
+    while (stepped.has_waiting_patterns())
+    {
+      while (stepped.has_waiting_patterns())
+      {
+        stepped.add_score_to_current_player(stepped.remove_first_pattern());
+      }
+      stepped.update_pattern_waiting_list();
+    }
+    stepped.next_turn();
+    stepped.new_colour();
+
+    resolved.set_index(index);
+    resolved.play_turn(log);
+
+    passed = resolved.get_field()->search_patterns(log.patterns) == 0;
+    for (int i = 0; i < rows * cols; i++)
+    {
+      passed &= stepped.get_field()->colour_at(i)
+        == resolved.get_field()->colour_at(i);
+    }
+    for (int player = 0; player < 2; player++)
+    {
+      passed &= stepped.get_score_of_player(player)
+        == resolved.get_score_of_player(player);
+      passed &= stepped.get_blobs_of_player(player)
+        == resolved.get_blobs_of_player(player);
+    }
+
+    summed_tests += 1;
+    passed_tests += passed;
+
+    if (verbose && !passed) std::cout
+      << "[" << (summed_tests) << "] Failed in turn " << turn << std::endl
+        << field_to_string(resolved.get_field()) << std::endl;
+  }
+
+  passed = passed_tests == summed_tests;
+
+  if (verbose) std::cout
+    << "[Result] Game rows: " << rows << ", cols: " << cols
+    << " -- Passed/Summed: "
+    << passed_tests << "/" << summed_tests
+    << " -- " << (passed ? "PASSED" : "FAILED") << "!"
+    << std::endl << "-------"
+    << std::endl << std::endl;
+
+  return passed;
+}
+
+/* Same cells, scores, blobs, player and waiting colours. */
+bool same_game(Game &a, Game &b)
+{
+  bool same = a.get_hash() == b.get_hash()
+    && a.get_current_player() == b.get_current_player()
+    && a.count_colours_waiting() == b.count_colours_waiting();
+
+  for (int i = 0; i < a.get_field()->get_size(); i++)
+  {
+    same &= a.get_field()->colour_at(i) == b.get_field()->colour_at(i);
+  }
+  for (long unsigned int i = 0; same && i < a.count_colours_waiting(); i++)
+  {
+    same &= a.get_waiting_colour(i) == b.get_waiting_colour(i);
+  }
+  for (int player = 0; player < 2; player++)
+  {
+    same &= a.get_score_of_player(player) == b.get_score_of_player(player);
+    same &= a.get_blobs_of_player(player) == b.get_blobs_of_player(player);
+  }
+
+  return same;
+}
+
+/* Every insertion made and unmade again restores the game; made, it is
+ * the same as a played turn. Unmaking all kept moves restores the start,
+ * which is also started again by the same seed. */
+bool test_game_undo(int rows, int cols, bool verbose = true, int turns = 20)
+{
+  int passed_tests = 0, summed_tests = 0;
+  bool passed;
+
+  Game game(rows, cols, 4);
+  GameUndo undo;
+  CascadeLog log;
+
+  for (int colour = 0; colour <= 4; colour++)
+  {
+    game.set_colour_score(colour, 10 * colour);
+  }
+
+  game.start();
+
+  Game started = game;
+
+  if (verbose) std::cout
+    << "## Game(" << rows << "," << cols << ") "
+      << "unmakes made moves." << std::endl;
+
+  for (int turn = 0; turn < turns; turn++)
+  {
+    Game before = game;
+    passed = true;
+
+    for (int index = 0; index < game.get_field()->get_bounds_max(); index++)
+    {
+      Game played = game;  // with the same random engine.
+
+      played.set_index(index);
+      int played_score = played.play_turn(log);
+
+      passed &= game.make_move(index, undo) == played_score;
+      passed &= same_game(game, played);
+
+      game.make_move(rand() % game.get_field()->get_bounds_max(), undo);
+      game.unmake_move(undo);
+      game.unmake_move(undo);
+
+      passed &= same_game(game, before) && undo.count_moves() == turn;
+    }
+
+    game.make_move(rand() % game.get_field()->get_bounds_max(), undo);
+
+    summed_tests += 1;
+    passed_tests += passed;
+
+    if (verbose && !passed) std::cout
+      << "[" << (summed_tests) << "] Failed in turn " << turn << std::endl
+        << field_to_string(game.get_field()) << std::endl;
+  }
+
+  while (undo.count_moves()) game.unmake_move(undo);
+
+  passed = same_game(game, started) && undo.field.changes.empty();
+
+  // the same seed starts the same game.
+  Game replayed(rows, cols, 4, 10, 3, game.get_seed());
+  for (int colour = 0; colour <= 4; colour++)
+  {
+    replayed.set_colour_score(colour, 10 * colour);
+  }
+  replayed.start();
+
+  passed &= same_game(replayed, started);
+  summed_tests += 1;
+  passed_tests += passed;
+
+  passed = passed_tests == summed_tests;
+
+  if (verbose) std::cout
+    << "[Result] Game rows: " << rows << ", cols: " << cols
+    << " -- Passed/Summed: "
+    << passed_tests << "/" << summed_tests
+    << " -- " << (passed ? "PASSED" : "FAILED") << "!"
+    << std::endl << "-------"
+    << std::endl << std::endl;
+
+  return passed;
+}
+
+/* A recorded game is read back turn by turn, and its seed and turns
+ * play the same game again. */
+bool test_game_replay(int rows, int cols, bool verbose = true, int turns = 200)
+{
+  bool passed;
+  std::stringstream stream;
+  std::vector<ReplayTurn> played;
+  CascadeLog log;
+
+  Game game(rows, cols, 4, 10, 3, rand());
+
+  for (int colour = 0; colour <= 4; colour++)
+  {
+    game.set_colour_score(colour, 10 * colour);
+  }
+
+  if (verbose) std::cout
+    << "## Game(" << rows << "," << cols << ") "
+      << "replays its record." << std::endl;
+
+  {
+    ReplayWriter writer(stream, 64);  // small buffer: many hand overs.
+
+    game.set_recorder(&writer);
+    game.start();
+
+    for (int turn = 0; turn < turns; turn++)
+    {
+      ReplayTurn t;
+      t.index = rand() % game.get_field()->get_bounds_max();
+      t.colour = game.get_waiting_colour();
+
+      game.set_index(t.index);
+      game.play_turn(log);
+
+      t.queued.push_back(game.get_waiting_colour(game.count_colours_waiting() - 1));
+      played.push_back(t);
+
+      if (turn == turns / 2)  // copies play, but do not record.
+      {
+        Game copy(game), assigned;
+        assigned = game;
+        copy.play_turn(log);
+        assigned.play_turn(log);
+      }
+    }
+
+    game.set_recorder(NULL);
+  }
+
+  ReplayReader reader(stream);
+  ReplayHeader header;
+  ReplayTurn turn;
+
+  passed = reader.read_header(header)
+    && header.rows == rows && header.cols == cols && header.colours == 4
+    && header.blobs == 10 && header.waiting == 3
+    && header.seed == game.get_seed();
+
+  Game replayed(header.rows, header.cols, header.colours, header.blobs,
+      header.waiting, header.seed);
+  for (int colour = 0; colour <= 4; colour++)
+  {
+    replayed.set_colour_score(colour, 10 * colour);
+  }
+  replayed.start();
+
+  for (ReplayTurn &t : played)
+  {
+    passed &= reader.read_turn(turn) && turn.index == t.index
+      && turn.colour == t.colour && turn.queued == t.queued;
+
+    replayed.set_index(turn.index);
+    replayed.play_turn(log);
+  }
+
+  passed &= !reader.read_turn(turn) && same_game(replayed, game);
+  passed &= stream.str().size() <= 20 + 3 * played.size();
+
+  if (verbose) std::cout
+    << "[1] " << (passed ? "Passed" : "Failed")
+    << " (" << stream.str().size() << " bytes)" << std::endl << std::endl;
+
+  return passed;
+}
+
+/* Seeking any turn of a recorded game, from its keyframes, gives the game
+ * as it was before that turn; also, if its colours did not come from the
+ * recorded seed (here: reseeded in the middle of the game). */
+bool test_replay_seek(int rows, int cols, bool verbose = true,
+    int turns = 300, int interval = 16)
+{
+  bool passed;
+  std::stringstream stream;
+  std::vector<int> colour_scores = {0, 10, 20, 30, 40};
+  std::vector<Game> history;
+  std::string path = temp_path("slideablob_keyframes");
+  CascadeLog log;
+
+  Game game(rows, cols, 4, 10, 3, rand());
+
+  for (int colour = 0; colour <= 4; colour++)
+  {
+    game.set_colour_score(colour, colour_scores[colour]);
+  }
+
+  if (verbose) std::cout
+    << "## Game(" << rows << "," << cols << ") "
+      << "seeks turns of its replay." << std::endl;
+
+  {
+    ReplayWriter writer(stream);
+
+    game.set_recorder(&writer);
+    game.start();
+
+    for (int turn = 0; turn <= turns; turn++)
+    {
+      history.push_back(game);  // copies do not record.
+
+      if (turn == turns) break;
+      if (turn == turns / 2) game.set_seed(rand());
+
+      game.set_index(rand() % game.get_field()->get_bounds_max());
+      game.play_turn(log);
+    }
+
+    game.set_recorder(NULL);
+  }
+
+  ReplaySeeker seeker;
+
+  passed = seeker.open(stream, colour_scores, path, interval)
+    && seeker.count_turns() == turns && seeker.count_differing() > 0;
+
+  for (int i = 0; passed && i < 50; i++)
+  {
+    int turn = i == 0 ? turns : rand() % (turns + 1);
+
+    passed &= same_game(seeker.seek(turn), history[turn])
+      && seeker.count_applied() < interval;
+  }
+
+  std::remove(path.c_str());
+
+  if (verbose) std::cout
+    << "[1] " << (passed ? "Passed" : "Failed") << std::endl << std::endl;
+
+  return passed;
+}
+
+/* A session, ticked until the next turn, plays like a whole turn;
+ * every pattern is shown for its ticks. */
+bool test_game_session(int rows, int cols, bool verbose = true, int turns = 30)
+{
+  int passed_tests = 0, summed_tests = 0;
+  bool passed, scorer;
+  uint64_t seed = rand();
+
+  GameSession session(rows, cols, 4, 10, 3, seed, 3);
+  Game &stepped = session.get_game();
+  Game played(rows, cols, 4, 10, 3, seed);
+  CascadeLog log;
+
+  for (int colour = 0; colour <= 4; colour++)
+  {
+    stepped.set_colour_score(colour, 10 * colour);
+    played.set_colour_score(colour, 10 * colour);
+  }
+
+  session.start();
+  played.start();
+
+  if (verbose) std::cout
+    << "## GameSession(" << rows << "," << cols << ") "
+      << "ticks turns like played ones." << std::endl;
+
+  for (int turn = 0; turn < turns; turn++)
+  {
+    int index = rand() % played.get_field()->get_bounds_max();
+    long ticks = session.get_ticks();
+    int scorers = 0;
+
+    session.set_index(index);
+    session.tick();  // not confirmed: nothing.
+    session.confirm();
+    session.tick();  // inserted.
+
+    passed = session.get_phase() == SESSION_REMOVING;
+
+    session.set_index(index + 1);  // ignored while removing.
+
+    while (session.get_phase() == SESSION_REMOVING)
+    {
+      passed &= session.get_progress() >= 0 && session.get_progress() <= 1;
+
+      // the shown pattern: at least three cells of one colour, cells shared
+      // with an already removed pattern are empty.
+      PatternCells cells = stepped.get_first_pattern();
+      int shown = 0;
+      passed &= cells.empty() == !stepped.has_waiting_patterns()
+        && (cells.empty() || cells.size() >= 3);
+      for (int i : cells)
+      {
+        int colour = stepped.get_field()->colour_at(i);
+        passed &= !colour || !shown || colour == shown;
+        if (colour) shown = colour;
+      }
+
+      session.tick();
+    }
+
+    while (session.pop_scorer(scorer)) scorers++;
+
+    played.set_index(index);
+    played.play_turn(log);
+
+    passed &= same_game(stepped, played)
+      && scorers == (int) log.patterns.size()
+      && session.get_ticks() - ticks >= 2 + 3 * scorers;
+
+    summed_tests += 1;
+    passed_tests += passed;
+
+    if (verbose && !passed) std::cout
+      << "[" << (summed_tests) << "] Failed in turn " << turn << std::endl
+        << field_to_string(stepped.get_field()) << std::endl;
+  }
+
+  passed = passed_tests == summed_tests;
+
+  if (verbose) std::cout
+    << "[Result] GameSession rows: " << rows << ", cols: " << cols
+    << " -- Passed/Summed: "
+    << passed_tests << "/" << summed_tests
+    << " -- " << (passed ? "PASSED" : "FAILED") << "!"
+    << std::endl << "-------"
+    << std::endl << std::endl;
+
+  return passed;
+}
+
+/* The greedy player finds the best scoring index, like playing each one,
+ * and leaves the game as it was. */
+bool test_greedy_player(int rows, int cols, bool verbose = true, int turns = 10)
+{
+  int passed_tests = 0, summed_tests = 0;
+  bool passed;
+
+  Game game(rows, cols, 4);
+  GreedyPlayer ai(3);
+  CascadeLog log;
+
+  for (int colour = 0; colour <= 4; colour++)
+  {
+    game.set_colour_score(colour, 10 * colour);
+  }
+
+  game.start();
+
+  if (verbose) std::cout
+    << "## GreedyPlayer(" << ai.count_threads() << ") on Game("
+      << rows << "," << cols << ") finds the best index." << std::endl;
+
+  for (int turn = 0; turn < turns; turn++)
+  {
+    int best_index = 0, best_score = -1;
+
+    for (int index = 0; index < game.get_field()->get_bounds_max(); index++)
+    {
+      Game played = game;
+      played.set_index(index);
+
+      int score = played.play_turn(log);
+      if (score > best_score)
+      {
+        best_score = score;
+        best_index = index;
+      }
+    }
+
+    Game before = game;
+
+    passed = ai.choose_index(game, 10000) == best_index
+      && ai.get_best_score() == best_score
+      && ai.count_evaluated() == game.get_field()->get_bounds_max()
+      && same_game(game, before);
+
+    passed &= ai.choose_index(game, 0) < game.get_field()->get_bounds_max()
+      && ai.count_evaluated() >= 1;
+
+    summed_tests += 1;
+    passed_tests += passed;
+
+    if (verbose && !passed) std::cout
+      << "[" << (summed_tests) << "] Failed in turn " << turn << std::endl
+        << field_to_string(game.get_field()) << std::endl;
+
+    game.set_index(rand() % game.get_field()->get_bounds_max());
+    game.play_turn(log);
+  }
+
+  passed = passed_tests == summed_tests;
+
+  if (verbose) std::cout
+    << "[Result] GreedyPlayer rows: " << rows << ", cols: " << cols
+    << " -- Passed/Summed: "
+    << passed_tests << "/" << summed_tests
+    << " -- " << (passed ? "PASSED" : "FAILED") << "!"
+    << std::endl << "-------"
+    << std::endl << std::endl;
+
+  return passed;
+}
+
+/* Expectimax by copying fields: value for the player to move. */
+int expectimax_value(
+    Game &game, Field &field, std::vector<int> &known, int ply, int depth)
+{
+  if (depth < 1) return 0;
+
+  int colours = (long unsigned int) ply < known.size() ? 1 : game.count_colours();
+  int value = 0;
+
+  for (int c = 1; c <= colours; c++)
+  {
+    int colour = colours == 1 ? known[ply] : c;
+    int best = 0;
+
+    for (int index = 0; index < field.get_bounds_max(); index++)
+    {
+      Field next = field;
+      std::vector<FieldPattern> patterns;
+      int score = 0;
+
+      next.insert(index, colour);
+      while (next.search_patterns(patterns))
+      {
+        for (FieldPattern p : patterns) score += game.get_pattern_score(p);
+        next.remove_patterns(patterns);
+      }
+
+      score -= expectimax_value(game, next, known, ply + 1, depth - 1);
+      if (index == 0 || score > best) best = score;
+    }
+
+    value += best;
+  }
+
+  return value / colours;
+}
+
+/* The threaded search finds the values of copying expectimax,
+ * and always completes the first turn. */
+bool test_expectimax_player(int rows, int cols, bool verbose = true, int turns = 3)
+{
+  int passed_tests = 0, summed_tests = 0;
+  bool passed;
+
+  Game game(rows, cols, 3);
+  ExpectimaxPlayer ai(3, 4);
+  CascadeLog log;
+  std::vector<int> known;
+
+  for (int colour = 0; colour <= 3; colour++)
+  {
+    game.set_colour_score(colour, 10 * colour);
+  }
+
+  game.start();
+
+  if (verbose) std::cout
+    << "## ExpectimaxPlayer(" << ai.count_threads() << ") on Game("
+      << rows << "," << cols << ") searches like expectimax." << std::endl;
+
+  for (int turn = 0; turn < turns; turn++)
+  {
+    Field field = *game.get_field();
+    Game before = game;
+
+    known.clear();
+    for (long unsigned int i = 0; i < game.count_colours_waiting(); i++)
+    {
+      known.push_back(game.get_waiting_colour(i));
+    }
+
+    int index = ai.choose_index(game, 60000);
+
+    Field next = field;
+    int score = 0;
+    next.insert(index, known[0]);
+    while (next.search_patterns(log.patterns))
+    {
+      for (FieldPattern p : log.patterns) score += game.get_pattern_score(p);
+      next.remove_patterns(log.patterns);
+    }
+
+    passed = ai.get_depth() == 4 && same_game(game, before)
+      && ai.get_best_value() == expectimax_value(game, field, known, 0, 4)
+      && ai.get_best_value()
+        == score - expectimax_value(game, next, known, 1, 3);
+
+    passed &= ai.choose_index(game, 0) < field.get_bounds_max()
+      && ai.get_depth() >= 1;
+
+    summed_tests += 1;
+    passed_tests += passed;
+
+    if (verbose && !passed) std::cout
+      << "[" << (summed_tests) << "] Failed in turn " << turn << std::endl
+        << field_to_string(game.get_field()) << std::endl;
+
+    game.set_index(index);
+    game.play_turn(log);
+  }
+
+  passed = passed_tests == summed_tests;
+
+  if (verbose) std::cout
+    << "[Result] ExpectimaxPlayer rows: " << rows << ", cols: " << cols
+    << " -- Passed/Summed: "
+    << passed_tests << "/" << summed_tests
+    << " -- " << (passed ? "PASSED" : "FAILED") << "!"
+    << std::endl << "-------"
+    << std::endl << std::endl;
+
+  return passed;
+}
+
+/* The field hash, updated on every change, is the hash of a new field with
+ * the same cells; the transposition table returns what was stored. */
+bool test_field_hash(int rows, int cols, bool verbose = true, int moves = 50)
+{
+  int passed_tests = 0, summed_tests = 0;
+  bool passed = true;
+  std::vector<int> cells;
+
+  Field field(rows, cols);
+  field.start(3);
+
+  if (verbose) std::cout
+    << "## Field(" << rows << "," << cols << ") "
+      << "hash is the hash of its cells." << std::endl;
+
+  for (int move = 0; move < moves; move++)
+  {
+    field.insert(rand() % field.get_bounds_max(), 1 + rand() % 3);
+    field.remove_patterns(field.search_patterns());
+
+    cells.clear();
+    for (int i = 0; i < field.get_size(); i++) cells.push_back(field.colour_at(i));
+
+    Field fresh(rows, cols);
+    fresh.start(cells);
+
+    passed &= fresh.get_hash() == field.get_hash();
+  }
+
+  summed_tests += 1;
+  passed_tests += passed;
+
+  if (verbose) std::cout
+    << "[" << (summed_tests) << "] "
+      << (passed ? "Passed" : "Failed") << std::endl << std::endl;
+
+  if (verbose) std::cout << "## Transposition table keeps entries." << std::endl;
+
+  TranspositionTable table(8);
+  TranspositionEntry entry;
+
+  table.store(field.get_hash(), TranspositionEntry(-1234, 3, rows, BOUND_LOWER));
+  table.store(field.get_hash(), TranspositionEntry(99, 1, 0, BOUND_EXACT));  // shallower
+
+  passed = table.probe(field.get_hash(), entry)
+    && entry.score == -1234 && entry.depth == 3
+    && entry.move == rows && entry.bound == BOUND_LOWER;
+  passed &= !table.probe(field.get_hash() ^ 1, entry);
+
+  summed_tests += 1;
+  passed_tests += passed;
+
+  if (verbose) std::cout
+    << "[" << (summed_tests) << "] "
+      << (passed ? "Passed" : "Failed") << std::endl << std::endl;
+
+  return passed_tests == summed_tests;
+}
+
+/* The ring queue keeps the order of a deque, over wraps and growth. */
+bool test_ring_queue(bool verbose = true, int operations = 1000)
+{
+  bool passed = true;
+  RingQueue<int> queue(4);
+  std::vector<int> expected;
+
+  if (verbose) std::cout << "## RingQueue works like a deque." << std::endl;
+
+  for (int op = 0; op < operations; op++)
+  {
+    int item = rand();
+
+    switch (rand() % 4)
+    {
+      case 0: queue.push_back(item); expected.push_back(item); break;
+      case 1: queue.push_front(item); expected.insert(expected.begin(), item); break;
+      case 2:
+        queue.pop_front();
+        if (expected.size()) expected.erase(expected.begin());
+        break;
+      default:
+        queue.pop_back();
+        if (expected.size()) expected.pop_back();
+        break;
+    }
+
+    passed &= queue.size() == expected.size();
+    for (long unsigned int i = 0; passed && i < expected.size(); i++)
+    {
+      passed &= queue[i] == expected[i];
+    }
+  }
+
+  if (verbose) std::cout
+    << "[1] " << (passed ? "Passed" : "Failed")
+    << " (capacity " << queue.capacity() << ")" << std::endl << std::endl;
+
+  return passed;
+}
+
+/* Every run kernel, this machine can run, finds the same as the scalar one. */
+bool test_field_kernel(bool verbose = true, int lines = 200)
+{
+  std::vector<triple_finder> finders;
+  std::vector<std::string> names;
+
+#ifdef FIELD_KERNEL_X86
+  if (__builtin_cpu_supports("sse2"))
+  {
+    finders.push_back(find_triple_sse2);
+    names.push_back("SSE2");
+  }
+  if (__builtin_cpu_supports("avx2"))
+  {
+    finders.push_back(find_triple_avx2);
+    names.push_back("AVX2");
+  }
+#endif
+
+  int passed_tests = 0, summed_tests = 0;
+  bool passed;
+
+  for (long unsigned int k = 0; k < finders.size(); k++)
+  {
+    if (verbose) std::cout
+      << "## Run kernel " << names[k] << " finds like scalar." << std::endl;
+
+    passed = true;
+    for (int l = 0; l < lines; l++)
+    {
+      int n = 1 + rand() % 70;
+      std::vector<int> a, b, c;
+
+      for (int j = 0; j < n; j++)  // few colours and some empty cells.
+      {
+        a.push_back(rand() % 3);
+        b.push_back(rand() % 3);
+        c.push_back(rand() % 3);
+      }
+
+      for (int from = 0; from <= n; from++)
+      {
+        passed &= finders[k](a.data(), b.data(), c.data(), n, from)
+          == find_triple_scalar(a.data(), b.data(), c.data(), n, from);
+      }
+    }
+
+    summed_tests += 1;
+    passed_tests += passed;
+
+    if (verbose) std::cout
+      << "[" << (summed_tests) << "] "
+        << (passed ? "Passed" : "Failed") << std::endl << std::endl;
+  }
+
+  return passed_tests == summed_tests;
+}
+
+/* The pacer draws only requested frames, at most fps per second, and lets
+ * an idle loop sleep until the next wakeup or event. */
+bool test_frame_pacer(bool verbose = true, int fps = 50)
+{
+  int passed_tests = 0, summed_tests = 0;
+  bool passed;
+  FramePacer pacer(fps);
+  long now = 100000;
+
+  if (verbose) std::cout << "## FramePacer(" << fps << ") paces frames." << std::endl;
+
+  /* Animating: requested in every 1 ms step, drawn once per frame time. */
+  passed = pacer.begin_frame(now);
+  for (int ms = 0; ms < 1000; ms++)
+  {
+    now ++;
+    pacer.request_frame();
+    passed &= pacer.get_timeout(now) <= 1000 / fps;
+    pacer.begin_frame(now);
+  }
+  passed &= pacer.count_frames() == 1 + fps;
+
+  summed_tests += 1;
+  passed_tests += passed;
+
+  if (verbose) std::cout
+    << "[" << summed_tests << "] " << pacer.count_frames() << " frames in 1 s: "
+      << (passed ? "Passed" : "Failed") << std::endl;
+
+  /* Idle: nothing drawn, sleep until the wakeup, else until an event. */
+  long frames = pacer.count_frames();
+  now += 1000;
+
+  pacer.request_wakeup(now + 500);
+  pacer.request_wakeup(now + 300);
+  passed = !pacer.begin_frame(now)
+    && pacer.get_timeout(now) == 300
+    && pacer.get_timeout(now) == -1  // the wakeup is forgotten.
+    && pacer.count_frames() == frames;
+
+  /* An event after a long sleep is drawn at once, not caught up. */
+  pacer.request_frame();
+  passed &= pacer.get_timeout(now) == 0 && pacer.begin_frame(now)
+    && !pacer.begin_frame(now + 1) && pacer.count_frames() == frames + 1;
+
+  summed_tests += 1;
+  passed_tests += passed;
+
+  passed = passed_tests == summed_tests;
+
+  if (verbose) std::cout
+    << "[" << summed_tests << "] Idle: "
+      << (passed ? "Passed" : "Failed") << std::endl
+    << "[Result] FramePacer -- Passed/Summed: "
+    << passed_tests << "/" << summed_tests
+    << " -- " << (passed ? "PASSED" : "FAILED") << "!"
+    << std::endl << std::endl;
+
+  return passed;
+}
+
+/* Only changed items are dirty, merged and clipped to the screen. */
+bool test_dirty_regions(bool verbose = true, int items = 100)
+{
+  int passed_tests = 0, summed_tests = 0;
+  bool passed;
+  DirtyRegions dirty(350, 480);
+  std::vector<long> states(items);
+
+  if (verbose) std::cout << "## DirtyRegions tracks changes." << std::endl;
+
+  /* A grid of 32x32 items, 4 pixels apart: first frame: whole screen. */
+  auto track_all = [&] ()
+  {
+    for (int i = 0; i < items; i++)
+    {
+      dirty.track(i, DirtyRect(4 + i % 10 * 36, 4 + i / 10 * 36, 32, 32),
+          states[i]);
+    }
+  };
+
+  track_all();
+  passed = dirty.get_rects().size() == 1
+    && dirty.get_rects()[0] == DirtyRect(0, 0, 350, 480);
+
+  /* Nothing changed, nothing dirty. */
+  dirty.clear();
+  track_all();
+  passed &= dirty.empty();
+
+  summed_tests += 1;
+  passed_tests += passed;
+
+  if (verbose) std::cout
+    << "[" << summed_tests << "] First and unchanged frame: "
+      << (passed ? "Passed" : "Failed") << std::endl;
+
+  /* Two apart items: two areas; touching areas are merged. */
+  states[0] ++;
+  states[55] ++;
+  track_all();
+  passed = dirty.get_rects().size() == 2;
+
+  dirty.clear();
+  dirty.mark(DirtyRect(-10, 470, 20, 20));  // clipped.
+  dirty.mark(DirtyRect(10, 460, 10, 10));  // touching.
+  passed &= dirty.get_rects().size() == 1
+    && dirty.get_rects()[0] == DirtyRect(0, 460, 20, 20);
+
+  /* A moved item: old and new area. */
+  dirty.clear();
+  dirty.track(items, DirtyRect(100, 400, 32, 32), 0);
+  dirty.clear();
+  dirty.track(items, DirtyRect(200, 400, 32, 32), 0);
+  passed &= dirty.get_rects().size() == 2;
+
+  summed_tests += 1;
+  passed_tests += passed;
+
+  passed = passed_tests == summed_tests;
+
+  if (verbose) std::cout
+    << "[" << summed_tests << "] Changed, merged and moved: "
+      << (passed ? "Passed" : "Failed") << std::endl
+    << "[Result] DirtyRegions -- Passed/Summed: "
+    << passed_tests << "/" << summed_tests
+    << " -- " << (passed ? "PASSED" : "FAILED") << "!"
+    << std::endl << std::endl;
+
+  return passed;
+}
+
+/* The atlas places the pictures without overlaps and finds their frames. */
+bool test_atlas_layout(bool verbose = true)
+{
+  bool passed;
+  AtlasLayout layout;
+
+  if (verbose) std::cout << "## AtlasLayout packs the sprites." << std::endl;
+
+  // the pictures of the game.
+  layout.add("blobs", 64, 192, 32, 32);
+  layout.add("colours", 256, 32, 32, 32);
+  layout.add("numbers", 190, 32, 19, 32);
+  layout.add("indicator", 32, 32, 19, 32);
+  layout.add("bg", 32, 32);
+
+  passed = layout.pack(300) && !AtlasLayout(layout).pack(200);
+
+  /* Every picture inside, none overlapping another. */
+  for (long unsigned int i = 0; i < layout.count_images(); i++)
+  {
+    const AtlasRect &a = layout.get_image(i).rect;
+
+    passed &= a.x >= 0 && a.y >= 0
+      && a.x + a.w <= layout.get_width() && a.x + a.w <= 300
+      && a.y + a.h <= layout.get_height();
+
+    for (long unsigned int j = 0; j < i; j++)
+    {
+      const AtlasRect &b = layout.get_image(j).rect;
+      passed &= a.x + a.w <= b.x || b.x + b.w <= a.x
+        || a.y + a.h <= b.y || b.y + b.h <= a.y;
+    }
+  }
+
+  /* Frames by name, row by row. */
+  int blobs = layout.find("blobs"), numbers = layout.find("numbers");
+  const AtlasImage &blob_image = layout.get_image(blobs);
+  const AtlasImage &number_image = layout.get_image(numbers);
+  const AtlasRect &blob = layout.get_frame(blob_image.first_frame + 2 * 2 + 1);
+  const AtlasRect &nine = layout.get_frame(number_image.first_frame + 9);
+
+  passed &= layout.count_frames() == 12 + 8 + 10 + 1 + 1
+    && layout.find("none") == -1
+    && blob.x == blob_image.rect.x + 32 && blob.y == blob_image.rect.y + 64
+    && nine.x == number_image.rect.x + 9 * 19 && nine.w == 19
+    && layout.get_image(layout.find("indicator")).frames_x == 1;
+
+  if (verbose) std::cout
+    << "[1] " << layout.get_width() << "x" << layout.get_height() << " "
+      << (passed ? "Passed" : "Failed") << std::endl << std::endl;
+
+  return passed;
+}
+
+/* Drawing into memory keeps the colour key and the clip area, the frame is
+ * the same after writing and reading it as BMP. */
+bool test_memory_renderer(bool verbose = true)
+{
+  bool passed;
+  MemoryRenderer renderer;
+
+  if (verbose) std::cout << "## MemoryRenderer draws headless." << std::endl;
+
+  /* Sprites: ten 1x2 digits (0xd0 + digit), the digit 1 with a hole. */
+  std::vector<uint32_t> sprites(10 * 2);
+  AtlasRect digits[10];
+  for (int d = 0; d < 10; d++)
+  {
+    sprites[d] = sprites[10 + d] = 0xd0 + d;
+    digits[d].x = d;
+    digits[d].w = 1;
+    digits[d].h = 2;
+  }
+  sprites[10 + 1] = SPRITE_KEY;
+
+  passed = renderer.open("", "", 8, 4) && renderer.load_sprites(sprites.data(), 10, 2);
+
+  const std::vector<uint32_t> &pixels = renderer.get_pixels();
+  renderer.fill_rect(DirtyRect(-2, -2, 20, 20), 0xffffff);
+
+  int x = 4;
+  display_number(105, &renderer, digits, x, 1);  // at 1..3, y 1..2.
+
+  passed &= x == 1
+    && pixels[1 * 8 + 1] == 0xd1 && pixels[2 * 8 + 1] == 0xffffff  // the hole.
+    && pixels[1 * 8 + 2] == 0xd0 && pixels[2 * 8 + 3] == 0xd5
+    && pixels[0 * 8 + 2] == 0xffffff && pixels[1 * 8 + 4] == 0xffffff;
+
+  /* Only inside of the clip area, also beyond the screen. */
+  DirtyRect clip(3, 0, 10, 2);
+  renderer.set_clip(&clip);
+  renderer.fill_rect(DirtyRect(0, 0, 8, 4), 0x123456);
+  renderer.draw_sprite(digits[7], 7, -1);
+  renderer.set_clip(NULL);
+  renderer.draw_sprite(digits[8], -1, 3);
+
+  passed &= pixels[1 * 8 + 2] == 0xd0 && pixels[1 * 8 + 3] == 0x123456
+    && pixels[2 * 8 + 3] == 0xd5 && pixels[0 * 8 + 7] == 0xd7
+    && pixels[1 * 8 + 7] == 0x123456;
+
+  renderer.present(std::vector<DirtyRect>());
+  renderer.present(std::vector<DirtyRect>(2, clip));
+  passed &= renderer.count_frames() == 1 && renderer.count_presented() == 40;
+
+  /* Written and read again. */
+  std::vector<uint32_t> read;
+  int w = 0, h = 0;
+  std::string path = temp_path("slideablob_memory_renderer");
+
+  passed &= write_bmp(path, pixels.data(), 8, 4) && read_bmp(path, read, w, h)
+    && w == 8 && h == 4 && read == pixels;
+
+  std::remove(path.c_str());
+
+  if (verbose) std::cout
+    << "[1] " << (passed ? "Passed" : "Failed") << std::endl << std::endl;
+
+  return passed;
+}
+
 #endif // _TESTS_H_
@@ -0,0 +1,218 @@
+#ifndef _TEST_SERVER_H_
+#define _TEST_SERVER_H_
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "server.h"
+
+/*
+ * Tests of the game server, run by the server target (server --test), so
+ * the game itself never opens a socket.
+ */
+
+/* Build a server request. */
+static std::vector<unsigned char> server_request(int op, uint32_t session,
+    uint32_t argument)
+{
+  std::vector<unsigned char> request(1, (unsigned char) op);
+
+  for (int i = 0; i < 4; i++) request.push_back((unsigned char) (session >> (8 * i)));
+  for (int i = 0; i < 4; i++) request.push_back((unsigned char) (argument >> (8 * i)));
+
+  return request;
+}
+
+/* Read an int32 of a reply's payload. */
+static uint32_t server_u32(const std::vector<unsigned char> &reply, int at)
+{
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) value |= (uint32_t) reply[3 + at + i] << (8 * i);
+  return value;
+}
+
+/* Sessions play like local games, directly and over the socket. */
+bool test_game_server(bool verbose = true, int sessions = 50, int turns = 10)
+{
+  int passed_tests = 0, summed_tests = 0;
+  bool passed = true;
+  GameServer server(2);
+  std::vector<unsigned char> reply;
+  std::vector<uint32_t> ids;
+
+  if (verbose) std::cout << "## GameServer serves sessions." << std::endl;
+
+  /* Many sessions: start, insert a few turns, poll. */
+  for (int s = 0; s < sessions; s++)
+  {
+    reply.clear();
+    server.handle_request(server_request(SERVER_START, 0, 0).data(), reply);
+    passed &= reply.size() == 7 && reply[0] == SERVER_OK;
+    if (reply.size() == 7) ids.push_back(server_u32(reply, 0));
+  }
+
+  passed &= server.count_sessions() == (long unsigned int) sessions;
+
+  for (uint32_t id : ids)
+  {
+    for (int turn = 0; turn < turns; turn++)
+    {
+      reply.clear();
+      server.handle_request(server_request(SERVER_SET_INDEX, id, rand() % 20).data(), reply);
+      server.handle_request(server_request(SERVER_INSERT, id, 0).data(), reply);
+      passed &= reply.size() == 14 && reply[0] == SERVER_OK && reply[7] == SERVER_OK;
+    }
+
+    reply.clear();
+    server.handle_request(server_request(SERVER_POLL, id, 0).data(), reply);
+    int waiting = reply.size() > 17 ? reply[3 + 16] : 0;
+    passed &= reply[0] == SERVER_OK && reply[3] == 5 && reply[4] == 5
+      && reply.size() == 3 + 17 + (long unsigned int) waiting + 25
+      && reply[1] + 256 * reply[2] == (int) reply.size() - 3;
+  }
+
+  summed_tests += 1;
+  passed_tests += passed;
+
+  if (verbose) std::cout
+    << "[" << summed_tests << "] " << sessions << " sessions played: "
+      << (passed ? "Passed" : "Failed") << std::endl;
+
+  /* Unknown sessions and operations, and ended sessions fail. */
+  reply.clear();
+  server.handle_request(server_request(SERVER_END, ids[0], 0).data(), reply);
+  server.handle_request(server_request(SERVER_POLL, ids[0], 0).data(), reply);
+  server.handle_request(server_request(42, ids[1], 0).data(), reply);
+  server.handle_request(server_request(SERVER_START, 0, 1 | 1 << 8 | 9 << 16 | 1 << 24).data(), reply);
+
+  passed = reply.size() == 12
+    && reply[0] == SERVER_OK && reply[3] == SERVER_ERROR
+    && reply[6] == SERVER_ERROR && reply[9] == SERVER_ERROR
+    && server.count_sessions() == (long unsigned int) sessions - 1;
+
+  /* No more sessions than allowed, until one ends. */
+  GameServer small(1, 2);
+  reply.clear();
+  for (int s = 0; s < 3; s++)
+  {
+    small.handle_request(server_request(SERVER_START, 0, 0).data(), reply);
+  }
+  passed &= reply.size() == 3 * 7 - 4
+    && reply[0] == SERVER_OK && reply[7] == SERVER_OK
+    && reply[14] == SERVER_ERROR && small.count_sessions() == 2;
+
+  small.handle_request(server_request(SERVER_END, server_u32(reply, 0), 0).data(), reply);
+  small.handle_request(server_request(SERVER_START, 0, 0).data(), reply);
+  passed &= reply.size() == 3 * 7 - 4 + 3 + 7 && reply[20] == SERVER_OK
+    && small.count_sessions() == 2;
+
+  summed_tests += 1;
+  passed_tests += passed;
+
+  if (verbose) std::cout
+    << "[" << summed_tests << "] Invalid requests, too many sessions: "
+      << (passed ? "Passed" : "Failed") << std::endl;
+
+  /* A finished game is still polled, but not played on. */
+  reply.clear();
+  server.handle_request(server_request(SERVER_START, 0, 4 | 4 << 8 | 2 << 16 | 1 << 24).data(), reply);
+  uint32_t over_id = server_u32(reply, 0);
+  bool over = false;
+
+  for (int turn = 0; turn < 10000 && !over; turn++)
+  {
+    reply.clear();
+    server.handle_request(server_request(SERVER_SET_INDEX, over_id, turn % 12).data(), reply);
+    server.handle_request(server_request(SERVER_INSERT, over_id, 0).data(), reply);
+    server.handle_request(server_request(SERVER_POLL, over_id, 0).data(), reply);
+    over = reply.size() > 20 && reply[14 + 3 + 3];  // poll: over.
+  }
+
+  reply.clear();
+  server.handle_request(server_request(SERVER_SET_INDEX, over_id, 0).data(), reply);
+  server.handle_request(server_request(SERVER_INSERT, over_id, 0).data(), reply);
+  server.handle_request(server_request(SERVER_POLL, over_id, 0).data(), reply);
+  server.handle_request(server_request(SERVER_END, over_id, 0).data(), reply);
+
+  passed = over && reply.size() > 6 + 3 + 3
+    && reply[0] == SERVER_ERROR && reply[3] == SERVER_ERROR
+    && reply[6] == SERVER_OK && reply[6 + 3 + 3] == 1
+    && server.count_sessions() == (long unsigned int) sessions - 1;
+
+  summed_tests += 1;
+  passed_tests += passed;
+
+  if (verbose) std::cout
+    << "[" << summed_tests << "] Finished game, no more turns: "
+      << (passed ? "Passed" : "Failed") << std::endl;
+
+  /* Round trip over the socket, requests split over two writes. */
+  std::string path = "/tmp/slideablob_test_" + std::to_string(getpid()) + ".sock";
+  passed = server.listen(path);
+
+  if (passed)
+  {
+    std::thread serving([&server] { server.run(); });
+
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path.c_str());
+
+    std::vector<unsigned char> requests = server_request(SERVER_START, 0, 4 | 6 << 8 | 4 << 16 | 2 << 24);
+    std::vector<unsigned char> poll = server_request(SERVER_POLL, ids[1], 0);
+    requests.insert(requests.end(), poll.begin(), poll.end());
+
+    passed = connect(client, (struct sockaddr *) &address, sizeof(address)) == 0
+      && write(client, requests.data(), 5) == 5
+      && write(client, requests.data() + 5, requests.size() - 5)
+        == (ssize_t) requests.size() - 5;
+
+    // expected: start (3 + 4), poll of a 5x5 game with 3 waiting.
+    long unsigned int expected = 7 + 3 + 17 + 3 + 25;
+    unsigned char buffer[256];
+    ssize_t got;
+
+    reply.clear();
+    while (passed && reply.size() < expected
+        && (got = read(client, buffer, sizeof(buffer))) > 0)
+    {
+      reply.insert(reply.end(), buffer, buffer + got);
+    }
+
+    passed &= reply.size() == expected && reply[0] == SERVER_OK
+      && reply[7] == SERVER_OK
+      && server.count_sessions() == (long unsigned int) sessions;
+
+    close(client);
+    server.stop();
+    serving.join();
+    unlink(path.c_str());
+  }
+
+  summed_tests += 1;
+  passed_tests += passed;
+
+  passed = passed_tests == summed_tests;
+
+  if (verbose) std::cout
+    << "[" << summed_tests << "] Socket round trip: "
+      << (passed ? "Passed" : "Failed") << std::endl
+    << "[Result] GameServer -- Passed/Summed: "
+    << passed_tests << "/" << summed_tests
+    << " -- " << (passed ? "PASSED" : "FAILED") << "!"
+    << std::endl << std::endl;
+
+  return passed;
+}
+
+#endif // _TEST_SERVER_H_
@@ -0,0 +1,127 @@
+#ifndef _TRANSPOSITION_H_
+#define _TRANSPOSITION_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#define BOUND_EXACT 0
+#define BOUND_LOWER 1
+#define BOUND_UPPER 2
+
+/* Evaluation of a position, packed into 64 bits for the table. */
+class TranspositionEntry
+{
+  public:
+    int score;  // from the view of the player to move.
+    int depth;  // searched plies, [0, 255]
+    int move;  // best insertion index, -1: none, [-1, 0xfffe]
+    int bound;  // BOUND_EXACT, BOUND_LOWER or BOUND_UPPER
+
+    TranspositionEntry(int score = 0, int depth = 0, int move = -1,
+        int bound = BOUND_EXACT)
+      : score(score), depth(depth), move(move), bound(bound)
+    {}
+
+    uint64_t pack()
+    {
+      return (uint64_t) (uint32_t) score
+        | (uint64_t) (depth & 0xff) << 32
+        | (uint64_t) ((move + 1) & 0xffff) << 40
+        | (uint64_t) (bound & 0x3) << 56;
+    }
+
+    static TranspositionEntry unpack(uint64_t data)
+    {
+      return TranspositionEntry(
+          (int32_t) (data & 0xffffffff),
+          (data >> 32) & 0xff,
+          (int) ((data >> 40) & 0xffff) - 1,
+          (data >> 56) & 0x3);
+    }
+};
+
+/**
+ * Fixed size hash table of evaluated positions, shared by search threads
+ * without locks: a slot keeps (key xor data) next to data, a torn write
+ * of another thread does not match the key anymore and reads as a miss.
+ * Keys come from Game::get_hash().
+ */
+class TranspositionTable
+{
+  private:
+    struct Slot
+    {
+      std::atomic<uint64_t> check;  // key ^ data
+      std::atomic<uint64_t> data;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    uint64_t mask;  // slot count - 1, slot count is a power of two.
+
+  public:
+    /* Create a table with 2^size_log2 slots (16 bytes each). */
+    TranspositionTable(int size_log2 = 20);
+
+    long unsigned int get_size();
+
+    /* Forget all positions. Not while other threads use the table. */
+    void clear();
+
+    /* Get the entry of that key, return false, if there is none. */
+    bool probe(uint64_t key, TranspositionEntry &entry);
+
+    /* Keep the entry, unless the slot has a deeper entry of the same key. */
+    void store(uint64_t key, TranspositionEntry entry);
+};
+
+TranspositionTable::TranspositionTable(int size_log2)
+{
+  size_log2 = size_log2 < 1 ? 1 : size_log2 > 30 ? 30 : size_log2;
+
+  this->mask = ((uint64_t) 1 << size_log2) - 1;
+  this->slots.reset(new Slot[mask + 1]);
+  this->clear();
+}
+
+long unsigned int TranspositionTable::get_size()
+{
+  return this->mask + 1;
+}
+
+void TranspositionTable::clear()
+{
+  for (uint64_t i = 0; i <= mask; i++)
+  {
+    slots[i].check.store(0, std::memory_order_relaxed);
+    slots[i].data.store(0, std::memory_order_relaxed);
+  }
+}
+
+bool TranspositionTable::probe(uint64_t key, TranspositionEntry &entry)
+{
+  Slot &slot = slots[key & mask];
+
+  uint64_t data = slot.data.load(std::memory_order_relaxed);
+  uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+  if ((check ^ data) != key || (!check && !data)) return false;
+
+  entry = TranspositionEntry::unpack(data);
+  return true;
+}
+
+void TranspositionTable::store(uint64_t key, TranspositionEntry entry)
+{
+  Slot &slot = slots[key & mask];
+  TranspositionEntry old;
+
+  if (this->probe(key, old) && old.depth > entry.depth) return;
+
+  uint64_t data = entry.pack();
+
+  slot.check.store(key ^ data, std::memory_order_relaxed);
+  slot.data.store(data, std::memory_order_relaxed);
+}
+
+#endif // _TRANSPOSITION_H_
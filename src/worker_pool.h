@@ -0,0 +1,102 @@
+#ifndef _WORKER_POOL_H_
+#define _WORKER_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Fixed set of threads, which all run the same job, until it is done.
+ * The threads wait between jobs, they are started only once. */
+class WorkerPool
+{
+  private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+
+    std::function<void(int)> job;
+    int turn = 0;  // counts jobs, a new job wakes the workers.
+    int running = 0;  // workers still on this job.
+    bool stopping = false;
+
+    void work(int worker);
+
+  public:
+    /* Start the workers, 0: one per hardware thread. */
+    WorkerPool(int threads = 0);
+
+    /* Stop and join the workers. */
+    ~WorkerPool();
+
+    int count_threads();
+
+    /* Run job(worker) on every worker, return when all are done. */
+    void run(std::function<void(int)> job);
+};
+
+WorkerPool::WorkerPool(int threads)
+{
+  if (threads < 1) threads = std::thread::hardware_concurrency();
+  if (threads < 1) threads = 1;
+
+  for (int i = 0; i < threads; i++)
+  {
+    this->workers.push_back(std::thread(&WorkerPool::work, this, i));
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->stopping = true;
+  }
+  wake.notify_all();
+
+  for (std::thread &worker : workers) worker.join();
+}
+
+int WorkerPool::count_threads()
+{
+  return this->workers.size();
+}
+
+void WorkerPool::run(std::function<void(int)> job)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+
+  this->job = job;
+  this->running = workers.size();
+  this->turn ++;
+
+  wake.notify_all();
+  done.wait(lock, [this] { return running == 0; });
+
+  this->job = NULL;
+}
+
+void WorkerPool::work(int worker)
+{
+  int seen_turn = 0;
+
+  std::unique_lock<std::mutex> lock(mutex);
+
+  while (true)
+  {
+    wake.wait(lock, [&] { return stopping || turn != seen_turn; });
+    if (stopping) return;
+
+    seen_turn = turn;
+    std::function<void(int)> &job = this->job;  // kept until all are done.
+
+    lock.unlock();
+    job(worker);
+    lock.lock();
+
+    if (--running == 0) done.notify_all();
+  }
+}
+
+#endif // _WORKER_POOL_H_